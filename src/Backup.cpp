@@ -0,0 +1,301 @@
+#include <QDir>
+#include <QFile>
+#include <QRegExp>
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QDataStream>
+#include <QCryptographicHash>
+
+#include <cstdio>
+
+#ifdef Q_OS_LINUX
+#include <errno.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#if defined(__GLIBC__) &&                                               \
+  (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 27))
+#define BMOD_HAVE_COPY_FILE_RANGE
+#endif
+#endif
+
+#ifdef MAC
+#include <sys/clonefile.h>
+#endif
+
+#include "Backup.h"
+#include "MappedFile.h"
+#include "CommitWriter.h"
+
+namespace {
+  const quint32 deltaMagic = 0x424D4444; // "BMDD"
+  const quint32 deltaVersion = 1;
+
+  // Contents of the whole file, mapped if possible.
+  class Contents {
+  public:
+    bool open(const QString &file) {
+      mapped = MappedFile::map(file);
+      if (mapped) {
+        data = mapped->getData();
+        size = mapped->getSize();
+        return true;
+      }
+
+      QFile f(file);
+      if (!f.open(QIODevice::ReadOnly)) {
+        return false;
+      }
+      buffer = f.readAll();
+      data = buffer.constData();
+      size = buffer.size();
+      return true;
+    }
+
+    QByteArray mid(qint64 pos, qint64 len) const {
+      if (pos < 0 || pos >= size) return QByteArray();
+      return QByteArray(data + pos, qMin(len, size - pos));
+    }
+
+    QByteArray hash() const {
+      return QCryptographicHash::hash(QByteArray::fromRawData(data, size),
+                                      QCryptographicHash::Sha1);
+    }
+
+    const char *data{nullptr};
+    qint64 size{0};
+
+  private:
+    MappedFilePtr mapped;
+    QByteArray buffer;
+  };
+
+  void setError(QString *error, const QString &msg) {
+    if (error) *error = msg;
+  }
+}
+
+bool Backup::saveDelta(const QString &file,
+                       const QList<BinaryObjectPtr> &objects,
+                       const QString &dest, QString *error) {
+  Contents orig;
+  if (!orig.open(file)) {
+    setError(error, QObject::tr("Could not open file for reading!"));
+    return false;
+  }
+
+  QSaveFile out(dest);
+  if (!out.open(QIODevice::WriteOnly)) {
+    setError(error, QObject::tr("Could not open backup for writing!"));
+    return false;
+  }
+
+  QList<qint64> offsets;
+  QList<QByteArray> oldData, newData;
+  foreach (const auto obj, objects) {
+    foreach (const auto sec, obj->getSections()) {
+      foreach (const auto &region, sec->getModifiedRegions().getRegions()) {
+        qint64 offset = (qint64) sec->getOffset() + region.first;
+        QByteArray old = orig.mid(offset, region.second);
+        if (old.isEmpty()) continue;
+        QByteArray data = sec->read(region.first, old.size());
+        offsets << offset;
+        oldData << old;
+        newData << QByteArray(data.constData(), data.size());
+      }
+    }
+  }
+
+  QDataStream stream(&out);
+  stream.setVersion(QDataStream::Qt_5_0);
+  stream << deltaMagic << deltaVersion << orig.size << orig.hash()
+         << (quint32) offsets.size();
+  for (int i = 0; i < offsets.size(); i++) {
+    stream << offsets[i] << oldData[i] << newData[i];
+  }
+
+  if (stream.status() != QDataStream::Ok || !out.commit()) {
+    setError(error, QObject::tr("Could not write backup: %1")
+             .arg(out.errorString()));
+    return false;
+  }
+  return true;
+}
+
+bool Backup::saveCopy(const QString &file, const QString &dest,
+                      QString *error) {
+  QFile::remove(dest);
+
+#ifdef MAC
+  if (clonefile(QFile::encodeName(file).constData(),
+                QFile::encodeName(dest).constData(), 0) == 0) {
+    return true;
+  }
+#endif
+
+#ifdef Q_OS_LINUX
+  QFile src(file), dst(dest);
+  if (src.open(QIODevice::ReadOnly) && dst.open(QIODevice::WriteOnly)) {
+    bool done{false};
+
+#ifdef FICLONE
+    // Share the blocks of the file on copy-on-write file systems.
+    done = (ioctl(dst.handle(), FICLONE, src.handle()) == 0);
+#endif
+
+#ifdef BMOD_HAVE_COPY_FILE_RANGE
+    // Copy without passing the data through user space.
+    qint64 left = src.size();
+    while (!done && left > 0) {
+      ssize_t n = copy_file_range(src.handle(), nullptr, dst.handle(), nullptr,
+                                  left, 0);
+      if (n < 0 && errno == EINTR) continue;
+      if (n <= 0) break;
+      left -= n;
+      done = (left == 0);
+    }
+#endif
+
+    dst.close();
+    if (done) {
+      dst.setPermissions(src.permissions());
+      return true;
+    }
+  }
+  QFile::remove(dest);
+#endif
+
+  if (!QFile::copy(file, dest)) {
+    setError(error, QObject::tr("Could not copy \"%1\" to \"%2\"!")
+             .arg(file).arg(dest));
+    return false;
+  }
+  return true;
+}
+
+bool Backup::isDelta(const QString &backup) {
+  QFile f(backup);
+  if (!f.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+  QDataStream stream(&f);
+  quint32 magic{0};
+  stream >> magic;
+  return magic == deltaMagic;
+}
+
+QStringList Backup::getBackups(const QString &file) {
+  QFileInfo fi(file);
+  QStringList files;
+  QRegExp re("^bak\\d+$");
+  foreach (const auto &entry,
+           fi.dir().entryInfoList(QStringList{fi.fileName() + ".bak*"},
+                                  QDir::Files, QDir::Name)) {
+    if (re.indexIn(entry.suffix()) != -1) {
+      files << entry.absoluteFilePath();
+    }
+  }
+  return files;
+}
+
+QString Backup::nextFileName(const QString &file) {
+  // The numbers are padded so the last one by name is the highest.
+  int num = 0;
+  QStringList files = getBackups(file);
+  if (!files.isEmpty()) {
+    num = QFileInfo(files.last()).suffix().mid(3).toInt();
+  }
+  return QString("%1.bak%2").arg(file).arg(num + 1, 4, 10, QChar('0'));
+}
+
+bool Backup::restore(const QString &backup, const QString &file,
+                     QString *error) {
+  if (!QFile::exists(backup)) {
+    setError(error, QObject::tr("Backup \"%1\" does not exist!").arg(backup));
+    return false;
+  }
+  if (isDelta(backup)) {
+    return restoreDelta(backup, file, error);
+  }
+  return restoreCopy(backup, file, error);
+}
+
+bool Backup::restoreCopy(const QString &backup, const QString &file,
+                         QString *error) {
+  // Copy next to the file and rename it over the file so it is never
+  // partially restored.
+  QString tmp = file + ".restore";
+  if (!saveCopy(backup, tmp, error)) {
+    return false;
+  }
+
+#ifndef Q_OS_WIN
+  if (std::rename(QFile::encodeName(tmp).constData(),
+                  QFile::encodeName(file).constData()) == 0) {
+    return true;
+  }
+#else
+  if (QFile::remove(file) && QFile::rename(tmp, file)) {
+    return true;
+  }
+#endif
+
+  QFile::remove(tmp);
+  setError(error, QObject::tr("Could not replace \"%1\"!").arg(file));
+  return false;
+}
+
+bool Backup::restoreDelta(const QString &backup, const QString &file,
+                          QString *error) {
+  QFile f(backup);
+  if (!f.open(QIODevice::ReadOnly)) {
+    setError(error, QObject::tr("Could not open backup for reading!"));
+    return false;
+  }
+
+  QDataStream stream(&f);
+  stream.setVersion(QDataStream::Qt_5_0);
+  quint32 magic, version, count;
+  qint64 size;
+  QByteArray hash;
+  stream >> magic >> version >> size >> hash >> count;
+  if (stream.status() != QDataStream::Ok || version != deltaVersion) {
+    setError(error, QObject::tr("Unsupported backup format!"));
+    return false;
+  }
+
+  Contents cur;
+  if (!cur.open(file)) {
+    setError(error, QObject::tr("Could not open file for reading!"));
+    return false;
+  }
+  if (cur.size != size) {
+    setError(error, QObject::tr("The file has changed since the backup!"));
+    return false;
+  }
+
+  CommitWriter writer(file);
+  writer.setExpectedHash(hash);
+  for (quint32 i = 0; i < count; i++) {
+    qint64 offset;
+    QByteArray oldData, newData;
+    stream >> offset >> oldData >> newData;
+    if (stream.status() != QDataStream::Ok) {
+      setError(error, QObject::tr("The backup is truncated!"));
+      return false;
+    }
+
+    // Only reverse the commit the backup was made for.
+    if (cur.mid(offset, newData.size()) != newData) {
+      setError(error, QObject::tr("The file has changed since the backup!"));
+      return false;
+    }
+    writer.addPatch(offset, oldData);
+  }
+
+  if (!writer.commit()) {
+    setError(error, writer.getError());
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,58 @@
+#ifndef BMOD_BACKUP_H
+#define BMOD_BACKUP_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include "BinaryObject.h"
+
+/**
+ * Backups of binaries made before committing changes. A delta backup
+ * only stores the original bytes of the regions about to be written,
+ * together with the new bytes and a hash of the whole original file,
+ * so it can be reversed safely. A full backup is a copy of the file.
+ */
+class Backup {
+public:
+  /**
+   * Save the original bytes of the modified regions of the objects'
+   * sections in file to dest.
+   */
+  static bool saveDelta(const QString &file,
+                        const QList<BinaryObjectPtr> &objects,
+                        const QString &dest, QString *error = nullptr);
+
+  /**
+   * Save a full copy of file to dest. The copy shares the blocks of the
+   * file if the file system supports it, and is otherwise copied in
+   * the kernel when possible.
+   */
+  static bool saveCopy(const QString &file, const QString &dest,
+                       QString *error = nullptr);
+
+  static bool isDelta(const QString &backup);
+
+  // Existing ".bakNNNN" backups of file, oldest first.
+  static QStringList getBackups(const QString &file);
+
+  // Name of the next ".bakNNNN" backup of file.
+  static QString nextFileName(const QString &file);
+
+  /**
+   * Restore file from a delta or full backup. A delta is only applied
+   * if the file still has the bytes written by the commit it was made
+   * for and the result matches the original hash, otherwise the file is
+   * left untouched.
+   */
+  static bool restore(const QString &backup, const QString &file,
+                      QString *error = nullptr);
+
+private:
+  static bool restoreCopy(const QString &backup, const QString &file,
+                          QString *error);
+  static bool restoreDelta(const QString &backup, const QString &file,
+                           QString *error);
+};
+
+#endif // BMOD_BACKUP_H
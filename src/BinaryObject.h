@@ -9,6 +9,7 @@
 #include "CpuType.h"
 #include "FileType.h"
 #include "SymbolTable.h"
+#include "PatchJournal.h"
 
 class BinaryObject;
 typedef std::shared_ptr<BinaryObject> BinaryObjectPtr;
@@ -45,6 +46,14 @@ public:
   void setDynSymbolTable(const SymbolTable &tbl) { dynsymTable = tbl; }
   const SymbolTable &getDynSymbolTable() const { return dynsymTable; }
 
+  // Sorted addresses of the functions, if known.
+  void setFunctionStarts(const QList<quint64> &starts) { funcStarts = starts; }
+  const QList<quint64> &getFunctionStarts() const { return funcStarts; }
+
+  // Edits of the sections should be written through the journal to be
+  // undoable.
+  PatchJournal &getJournal() { return journal; }
+
 private:
   CpuType cpuType, cpuSubType;
   bool littleEndian;
@@ -52,6 +61,8 @@ private:
   FileType fileType;
   QList<SectionPtr> sections;
   SymbolTable symTable, dynsymTable;
+  QList<quint64> funcStarts;
+  PatchJournal journal;
 };
 
 #endif // BMOD_BINARY_OBJECT_H
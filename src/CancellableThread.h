@@ -0,0 +1,39 @@
+#ifndef BMOD_CANCELLABLE_THREAD_H
+#define BMOD_CANCELLABLE_THREAD_H
+
+#include <QThread>
+#include <QAtomicInt>
+
+/**
+ * Worker thread that run() can be asked to leave early. The work is
+ * checked for cancellation between batches, so a batch that is being
+ * emitted when cancel() is called still arrives. Receivers therefore
+ * check isCancelled() before using a batch.
+ */
+class CancellableThread : public QThread {
+  Q_OBJECT
+
+public:
+  CancellableThread(QObject *parent = nullptr)
+    : QThread(parent), cancelled{0}
+  { }
+
+  void cancel() { cancelled.store(1); }
+  bool isCancelled() const { return cancelled.load() != 0; }
+
+  /**
+   * Cancel, wait for run() to return and delete the thread later.
+   * Signals of it still queued are delivered but cancelled, so
+   * receivers checking isCancelled() can ignore them.
+   */
+  void stop() {
+    cancel();
+    wait();
+    deleteLater();
+  }
+
+private:
+  QAtomicInt cancelled;
+};
+
+#endif // BMOD_CANCELLABLE_THREAD_H
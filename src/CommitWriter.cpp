@@ -0,0 +1,225 @@
+#include <QFile>
+#include <QSaveFile>
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+
+#include <algorithm>
+
+#ifdef Q_OS_UNIX
+#include <errno.h>
+#include <limits.h>
+#include <sys/uio.h>
+#include <vector>
+#endif
+
+#include "MappedFile.h"
+#include "CommitWriter.h"
+
+namespace {
+#ifdef Q_OS_UNIX
+#ifdef IOV_MAX
+  const int maxIov = IOV_MAX;
+#else
+  const int maxIov = 1024;
+#endif
+#endif
+}
+
+CommitWriter::CommitWriter(const QString &file)
+  : file{file}, bytesWritten{0}, elapsed{0}, regionCount{0}
+{ }
+
+void CommitWriter::addSection(SectionPtr section) {
+  if (section && section->isModified()) {
+    sections << section;
+  }
+}
+
+void CommitWriter::addObject(BinaryObjectPtr object) {
+  foreach (const auto sec, object->getSections()) {
+    addSection(sec);
+  }
+}
+
+void CommitWriter::addPatch(qint64 offset, const QByteArray &data) {
+  if (!data.isEmpty()) {
+    rawPatches << QPair<qint64, QByteArray>(offset, data);
+  }
+}
+
+bool CommitWriter::commit() {
+  QElapsedTimer timer;
+  timer.start();
+  bytesWritten = elapsed = 0;
+  regionCount = 0;
+  error.clear();
+
+  // The original bytes between the patches are taken from a mapping of
+  // the current file when possible.
+  QByteArray contents;
+  const char *orig{nullptr};
+  qint64 origSize{0};
+  MappedFilePtr mapped = MappedFile::map(file);
+  if (mapped) {
+    orig = mapped->getData();
+    origSize = mapped->getSize();
+  }
+  else {
+    QFile f(file);
+    if (!f.open(QIODevice::ReadOnly)) {
+      error = QObject::tr("Could not open file for reading!");
+      return false;
+    }
+    contents = f.readAll();
+    orig = contents.constData();
+    origSize = contents.size();
+  }
+
+  // Interleave the original bytes and the patches into spans covering
+  // the whole file in order.
+  QList<Span> spans;
+  qint64 pos{0};
+  foreach (auto patch, collectPatches()) {
+    if (patch.offset >= origSize) break;
+    if (patch.offset + patch.size > origSize) {
+      patch.size = origSize - patch.offset;
+    }
+    if (spans.isEmpty() || patch.offset > pos) {
+      regionCount++;
+    }
+    if (patch.offset > pos) {
+      spans << Span{pos, orig + pos, patch.offset - pos};
+    }
+    spans << patch;
+    bytesWritten += patch.size;
+    pos = patch.offset + patch.size;
+  }
+  if (pos < origSize) {
+    spans << Span{pos, orig + pos, origSize - pos};
+  }
+
+  if (!expectedHash.isEmpty()) {
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    foreach (const auto &span, spans) {
+      hash.addData(span.data, span.size);
+    }
+    if (hash.result() != expectedHash) {
+      error = QObject::tr("Contents would not match the expected hash!");
+      bytesWritten = regionCount = 0;
+      buffers.clear();
+      return false;
+    }
+  }
+
+  QSaveFile out(file);
+  if (!out.open(QIODevice::WriteOnly | QIODevice::Unbuffered)) {
+    error = QObject::tr("Could not open file for writing!");
+    bytesWritten = regionCount = 0;
+    buffers.clear();
+    return false;
+  }
+
+  if (!write(out, spans) || !out.commit()) {
+    out.cancelWriting();
+    error = QObject::tr("Could not write to file: %1").arg(out.errorString());
+    bytesWritten = regionCount = 0;
+    buffers.clear();
+    return false;
+  }
+
+  buffers.clear();
+  elapsed = timer.elapsed();
+  return true;
+}
+
+QList<CommitWriter::Span> CommitWriter::collectPatches() {
+  // Only the modified regions are read from the sections, which keeps
+  // the edited bytes alive until written without merging whole sections.
+  QList<Span> patches;
+  buffers.clear();
+  foreach (const auto sec, sections) {
+    foreach (const auto &region, sec->getModifiedRegions().getRegions()) {
+      buffers << sec->read(region.first, region.second);
+      const auto &data = buffers.last();
+      patches << Span{(qint64) sec->getOffset() + region.first,
+          data.constData(), data.size()};
+    }
+  }
+  foreach (const auto &patch, rawPatches) {
+    buffers << patch.second;
+    patches << Span{patch.first, patch.second.constData(),
+        patch.second.size()};
+  }
+
+  std::sort(patches.begin(), patches.end(),
+            [](const Span &a, const Span &b) { return a.offset < b.offset; });
+
+  // Merge patches that are adjacent both in the file and in memory, and
+  // clip any overlap so each file byte is written once.
+  QList<Span> merged;
+  foreach (auto patch, patches) {
+    if (!merged.isEmpty()) {
+      auto &last = merged.last();
+      qint64 end = last.offset + last.size;
+      if (patch.offset < end) {
+        qint64 overlap = qMin(end - patch.offset, patch.size);
+        patch.offset += overlap;
+        patch.data += overlap;
+        patch.size -= overlap;
+        if (patch.size == 0) continue;
+      }
+      if (patch.offset == end && patch.data == last.data + last.size) {
+        last.size += patch.size;
+        continue;
+      }
+    }
+    merged << patch;
+  }
+  return merged;
+}
+
+bool CommitWriter::write(QFileDevice &out, QList<Span> spans) {
+#ifdef Q_OS_UNIX
+  // The temporary file is written front to back so plain gathered
+  // writes are enough, and writev is available on every supported
+  // system unlike pwritev.
+  std::vector<struct iovec> iov;
+  int i = 0;
+  while (i < spans.size()) {
+    iov.clear();
+    for (int j = i; j < spans.size() && (int) iov.size() < maxIov; j++) {
+      struct iovec v;
+      v.iov_base = (void*) spans[j].data;
+      v.iov_len = spans[j].size;
+      iov.push_back(v);
+    }
+
+    ssize_t n = ::writev(out.handle(), iov.data(), iov.size());
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    if (n == 0) {
+      return false;
+    }
+
+    // Skip what was written which might end in the middle of a span.
+    while (n > 0 && i < spans.size()) {
+      auto &span = spans[i];
+      qint64 len = qMin((qint64) n, span.size);
+      span.data += len;
+      span.size -= len;
+      n -= len;
+      if (span.size == 0) i++;
+    }
+  }
+  return true;
+#else
+  foreach (const auto &span, spans) {
+    if (out.write(span.data, span.size) != span.size) {
+      return false;
+    }
+  }
+  return true;
+#endif
+}
@@ -0,0 +1,70 @@
+#ifndef BMOD_COMMIT_WRITER_H
+#define BMOD_COMMIT_WRITER_H
+
+#include <QList>
+#include <QPair>
+#include <QString>
+
+#include "Section.h"
+#include "BinaryObject.h"
+
+class QFileDevice;
+
+/**
+ * Writes the modified regions of sections back to their file. The
+ * regions of all added sections are sorted and merged by file offset
+ * and the new file is written front to back in gathered writes taking
+ * the bytes directly from the edited pages and the original file. The
+ * result is written to a temporary file that is renamed over the
+ * original, so the file is either fully committed or left untouched.
+ */
+class CommitWriter {
+public:
+  CommitWriter(const QString &file);
+
+  void addSection(SectionPtr section);
+  void addObject(BinaryObjectPtr object);
+
+  // Write data at the offset of the file.
+  void addPatch(qint64 offset, const QByteArray &data);
+
+  /**
+   * Only replace the file if the SHA-1 hash of the new contents matches,
+   * otherwise the file is left untouched and commit() fails.
+   */
+  void setExpectedHash(const QByteArray &hash) { expectedHash = hash; }
+
+  bool commit();
+
+  QString getError() const { return error; }
+
+  // Amount of modified bytes written.
+  qint64 getBytesWritten() const { return bytesWritten; }
+
+  // Amount of contiguous regions in the file the bytes were written to.
+  int getRegionCount() const { return regionCount; }
+
+  // Time spent committing in milliseconds.
+  qint64 getElapsed() const { return elapsed; }
+
+private:
+  struct Span {
+    qint64 offset;
+    const char *data;
+    qint64 size;
+  };
+
+  QList<Span> collectPatches();
+
+  bool write(QFileDevice &out, QList<Span> spans);
+
+  QString file, error;
+  QList<SectionPtr> sections;
+  QList<QPair<qint64, QByteArray>> rawPatches;
+  QList<QByteArray> buffers;
+  QByteArray expectedHash;
+  qint64 bytesWritten, elapsed;
+  int regionCount;
+};
+
+#endif // BMOD_COMMIT_WRITER_H
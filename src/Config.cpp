@@ -26,6 +26,7 @@ void Config::load() {
   backupAsk = settings.value("backupAsk", true).toBool();
   backupAmount = settings.value("backupAmount", 5).toInt();
   if (backupAmount < 0) backupAmount = 0;
+  backupFullCopy = settings.value("backupFullCopy", false).toBool();
   settings.endArray();
 }
 
@@ -41,6 +42,7 @@ void Config::save() {
   settings.setValue("backupEnabled", backupEnabled);
   settings.setValue("backupAsk", backupAsk);
   settings.setValue("backupAmount", backupAmount);
+  settings.setValue("backupFullCopy", backupFullCopy);
   settings.endGroup();
 
   settings.sync();
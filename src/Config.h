@@ -26,6 +26,9 @@ public:
   int getBackupAmount() const { return backupAmount; }
   void setBackupAmount(int amount) { backupAmount = amount; }
 
+  bool getBackupFullCopy() const { return backupFullCopy; }
+  void setBackupFullCopy(bool full) { backupFullCopy = full; }
+
 private:
   QSettings settings;
 
@@ -33,7 +36,7 @@ private:
   bool confirmCommit, confirmQuit;
 
   // Backup
-  bool backupEnabled, backupAsk;
+  bool backupEnabled, backupAsk, backupFullCopy;
   int backupAmount;
 };
 
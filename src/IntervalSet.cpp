@@ -0,0 +1,62 @@
+#include <iterator>
+
+#include "IntervalSet.h"
+
+void IntervalSet::add(int pos, int size) {
+  if (size <= 0) return;
+  int start = pos, end = pos + size;
+
+  // Start at the interval before if it reaches the new one.
+  auto it = intervals.upper_bound(start);
+  if (it != intervals.begin()) {
+    auto prev = std::prev(it);
+    if (prev->second >= start) {
+      it = prev;
+    }
+  }
+
+  // Absorb all intervals that overlap or touch.
+  while (it != intervals.end() && it->first <= end) {
+    start = qMin(start, it->first);
+    end = qMax(end, it->second);
+    it = intervals.erase(it);
+  }
+
+  intervals[start] = end;
+}
+
+bool IntervalSet::intersects(int start, int end) const {
+  if (start >= end) return false;
+
+  // The last interval starting before end is the only candidate.
+  auto it = intervals.lower_bound(end);
+  if (it == intervals.begin()) return false;
+  --it;
+  return it->second > start;
+}
+
+QList<QPair<int, int>> IntervalSet::getIntersecting(int start,
+                                                    int end) const {
+  QList<QPair<int, int>> res;
+  if (start >= end) return res;
+
+  auto it = intervals.upper_bound(start);
+  if (it != intervals.begin()) {
+    auto prev = std::prev(it);
+    if (prev->second > start) {
+      it = prev;
+    }
+  }
+  for (; it != intervals.end() && it->first < end; ++it) {
+    res << QPair<int, int>(it->first, it->second - it->first);
+  }
+  return res;
+}
+
+QList<QPair<int, int>> IntervalSet::getRegions() const {
+  QList<QPair<int, int>> res;
+  for (const auto &interval : intervals) {
+    res << QPair<int, int>(interval.first, interval.second - interval.first);
+  }
+  return res;
+}
@@ -0,0 +1,37 @@
+#ifndef BMOD_INTERVAL_SET_H
+#define BMOD_INTERVAL_SET_H
+
+#include <QList>
+#include <QPair>
+
+#include <map>
+
+/**
+ * Set of disjoint half-open intervals [start, end). Overlapping and
+ * adjacent intervals are merged when added. Adding and querying is
+ * logarithmic in the number of intervals.
+ */
+class IntervalSet {
+public:
+  bool isEmpty() const { return intervals.empty(); }
+  int size() const { return intervals.size(); }
+  void clear() { intervals.clear(); }
+
+  // Add [pos, pos + size).
+  void add(int pos, int size);
+
+  // Whether any interval intersects [start, end).
+  bool intersects(int start, int end) const;
+
+  // Intervals intersecting [start, end) as (position, size) pairs.
+  QList<QPair<int, int>> getIntersecting(int start, int end) const;
+
+  // All intervals as (position, size) pairs in ascending order.
+  QList<QPair<int, int>> getRegions() const;
+
+private:
+  // Start to end of each interval.
+  std::map<int, int> intervals;
+};
+
+#endif // BMOD_INTERVAL_SET_H
@@ -0,0 +1,30 @@
+#include "MappedFile.h"
+
+MappedFile::MappedFile(const QString &file)
+  : file{file}, data{nullptr}, size{0}
+{ }
+
+MappedFile::~MappedFile() {
+  if (data) {
+    file.unmap(data);
+    data = nullptr;
+  }
+}
+
+MappedFilePtr MappedFile::map(const QString &file) {
+  MappedFilePtr res(new MappedFile(file));
+  if (!res->file.open(QIODevice::ReadOnly)) {
+    return nullptr;
+  }
+
+  res->size = res->file.size();
+  if (res->size <= 0) {
+    return nullptr;
+  }
+
+  res->data = res->file.map(0, res->size);
+  if (!res->data) {
+    return nullptr;
+  }
+  return res;
+}
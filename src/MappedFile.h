@@ -0,0 +1,39 @@
+#ifndef BMOD_MAPPED_FILE_H
+#define BMOD_MAPPED_FILE_H
+
+#include <QFile>
+#include <QString>
+
+#include <memory>
+
+class MappedFile;
+typedef std::shared_ptr<MappedFile> MappedFilePtr;
+
+/**
+ * Read-only memory map of a whole file. The mapping lives as long as
+ * the object so share it with everything reading from it.
+ */
+class MappedFile {
+public:
+  ~MappedFile();
+
+  QString getFile() const { return file.fileName(); }
+  const char *getData() const { return (const char*) data; }
+  qint64 getSize() const { return size; }
+
+  /**
+   * Map the file into memory. Returns nullptr if the file could not be
+   * opened or mapped, like empty files, in which case the caller
+   * should fall back to reading it through a device.
+   */
+  static MappedFilePtr map(const QString &file);
+
+private:
+  MappedFile(const QString &file);
+
+  QFile file;
+  uchar *data;
+  qint64 size;
+};
+
+#endif // BMOD_MAPPED_FILE_H
@@ -0,0 +1,64 @@
+#include <QThread>
+#include <QRunnable>
+#include <QAtomicInt>
+#include <QThreadPool>
+
+#include "Parallel.h"
+
+namespace {
+  // Whether the current thread is a worker of a run.
+  thread_local bool inWorker{false};
+
+  class Worker : public QRunnable {
+  public:
+    Worker(int count, const std::function<void(int)> &func, QAtomicInt &next)
+      : count{count}, func(func), next(next)
+    { }
+
+    void run() {
+      // Take the next index until all are taken.
+      inWorker = true;
+      int i;
+      while ((i = next.fetchAndAddRelaxed(1)) < count) {
+        func(i);
+      }
+      inWorker = false;
+    }
+
+  private:
+    int count;
+    const std::function<void(int)> &func;
+    QAtomicInt &next;
+  };
+}
+
+void Parallel::run(int count, const std::function<void(int)> &func,
+                   int threads) {
+  if (count <= 0) return;
+
+  if (threads <= 0) {
+    threads = getThreadCount();
+  }
+  threads = qMin(threads, count);
+
+  // Nested runs use the calling worker instead of starting more threads
+  // than there are cores.
+  if (threads == 1 || inWorker) {
+    for (int i = 0; i < count; i++) {
+      func(i);
+    }
+    return;
+  }
+
+  QAtomicInt next{0};
+  QThreadPool pool;
+  pool.setMaxThreadCount(threads);
+  for (int i = 0; i < threads; i++) {
+    pool.start(new Worker(count, func, next));
+  }
+  pool.waitForDone();
+}
+
+int Parallel::getThreadCount() {
+  return qMax(1, QThread::idealThreadCount());
+}
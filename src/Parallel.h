@@ -0,0 +1,21 @@
+#ifndef BMOD_PARALLEL_H
+#define BMOD_PARALLEL_H
+
+#include <functional>
+
+class Parallel {
+public:
+  /**
+   * Calls func with each index from 0 to count - 1 on a pool of
+   * threads and returns when all calls are done. The order of the
+   * calls is undefined. If threads is 0 then the ideal thread count is
+   * used. Nested runs from within func are sequential.
+   */
+  static void run(int count, const std::function<void(int)> &func,
+                  int threads = 0);
+
+  // Ideal number of threads, at least 1.
+  static int getThreadCount();
+};
+
+#endif // BMOD_PARALLEL_H
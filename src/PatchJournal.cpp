@@ -0,0 +1,50 @@
+#include "PatchJournal.h"
+
+bool PatchJournal::write(SectionPtr section, const QByteArray &data, int pos) {
+  // The section ignores bytes past its end so only record what fits.
+  QByteArray old = section->read(pos, data.size());
+  if (old.isEmpty()) {
+    return false;
+  }
+
+  while (patches.size() > applied) {
+    patches.removeLast();
+  }
+  if (saved > applied) {
+    saved = -1;
+  }
+
+  // Read might refer to the original bytes, so keep a copy of them.
+  Patch patch{section, pos, QByteArray(old.constData(), old.size()),
+      data.left(old.size()), section->getModifiedRegions(), IntervalSet()};
+  section->setSubData(data, pos);
+  patch.newRegions = section->getModifiedRegions();
+  patches << patch;
+  applied++;
+  return true;
+}
+
+const PatchJournal::Patch *PatchJournal::undo() {
+  if (!canUndo()) {
+    return nullptr;
+  }
+  const auto &patch = patches[--applied];
+  patch.section->setSubData(patch.oldData, patch.pos);
+  patch.section->restoreModifiedRegions(patch.oldRegions);
+  return &patch;
+}
+
+const PatchJournal::Patch *PatchJournal::redo() {
+  if (!canRedo()) {
+    return nullptr;
+  }
+  const auto &patch = patches[applied++];
+  patch.section->setSubData(patch.newData, patch.pos);
+  patch.section->restoreModifiedRegions(patch.newRegions);
+  return &patch;
+}
+
+void PatchJournal::clear() {
+  patches.clear();
+  applied = saved = 0;
+}
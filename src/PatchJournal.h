@@ -0,0 +1,61 @@
+#ifndef BMOD_PATCH_JOURNAL_H
+#define BMOD_PATCH_JOURNAL_H
+
+#include <QList>
+#include <QByteArray>
+
+#include "Section.h"
+#include "IntervalSet.h"
+
+/**
+ * Undo and redo history of the byte patches of a binary object. Each
+ * patch only keeps the bytes it replaced and the bytes it wrote, and
+ * the modified regions of the section around it, so undoing all
+ * patches leaves the section unmodified.
+ */
+class PatchJournal {
+public:
+  struct Patch {
+    SectionPtr section;
+    int pos;
+    QByteArray oldData, newData;
+    IntervalSet oldRegions, newRegions;
+  };
+
+  PatchJournal() : applied{0}, saved{0} { }
+
+  /**
+   * Write data at pos of the section and record it as the latest
+   * patch, which discards any undone patches. Returns false if pos is
+   * outside the section.
+   */
+  bool write(SectionPtr section, const QByteArray &data, int pos);
+
+  bool canUndo() const { return applied > 0; }
+  bool canRedo() const { return applied < patches.size(); }
+
+  /**
+   * Revert the latest applied patch, or apply the latest undone patch,
+   * and return it. Returns nullptr if there is nothing to undo or redo.
+   * The patch is valid until the next write.
+   */
+  const Patch *undo();
+  const Patch *redo();
+
+  int size() const { return patches.size(); }
+  void clear();
+
+  /**
+   * Remember the applied patches as written to the file. The journal
+   * is saved while exactly those patches are applied.
+   */
+  void setSaved() { saved = applied; }
+  bool isSaved() const { return saved == applied; }
+
+private:
+  QList<Patch> patches;
+  int applied; // Patches before this are applied.
+  int saved; // Applied patches when last saved, or -1 if discarded.
+};
+
+#endif // BMOD_PATCH_JOURNAL_H
@@ -4,7 +4,13 @@
 #include "Reader.h"
 
 Reader::Reader(QIODevice &dev, bool littleEndian)
-  : dev{dev}, littleEndian{littleEndian}
+  : dev{&dev}, data{nullptr}, size{0}, offset{0}, littleEndian{littleEndian},
+  failed{false}
+{ }
+
+Reader::Reader(const char *data, qint64 size, bool littleEndian)
+  : dev{nullptr}, data{data}, size{size}, offset{0}, littleEndian{littleEndian},
+  failed{false}
 { }
 
 quint16 Reader::getUInt16(bool *ok) {
@@ -19,9 +25,36 @@ quint64 Reader::getUInt64(bool *ok) {
   return getUInt<quint64>(ok);
 }
 
+quint64 Reader::getULEB128(bool *ok) {
+  quint64 res{0};
+  int shift{0};
+  bool good;
+  unsigned char byte;
+  do {
+    byte = getUChar(&good);
+    if (!good || shift > 63) {
+      if (ok) *ok = false;
+      return 0;
+    }
+    res |= (quint64) (byte & 0x7F) << shift;
+    shift += 7;
+  } while (byte & 0x80);
+
+  if (ok) *ok = true;
+  return res;
+}
+
 char Reader::getChar(bool *ok) {
   char c{0};
-  bool res = dev.getChar(&c);
+  bool res;
+  if (dev) {
+    res = dev->getChar(&c);
+  }
+  else {
+    res = (offset < size);
+    if (res) c = data[offset++];
+  }
+  if (!res) failed = true;
   if (ok) *ok = res;
   return c;
 }
@@ -32,7 +65,14 @@ unsigned char Reader::getUChar(bool *ok) {
 
 char Reader::peekChar(bool *ok) {
   char c{0};
-  qint64 num = dev.peek(&c, 1);
+  qint64 num{0};
+  if (dev) {
+    num = dev->peek(&c, 1);
+  }
+  else if (offset < size) {
+    c = data[offset];
+    num = 1;
+  }
   if (ok) *ok = (num == 1);
   return c;
 }
@@ -42,32 +82,61 @@ unsigned char Reader::peekUChar(bool *ok) {
 }
 
 QByteArray Reader::read(qint64 max) {
-  return dev.read(max);
+  if (dev) {
+    return dev->read(max);
+  }
+  if (max <= 0 || offset >= size) {
+    return QByteArray();
+  }
+  qint64 num = qMin(max, size - offset);
+  QByteArray res(data + offset, num);
+  offset += num;
+  return res;
 }
 
 qint64 Reader::pos() const {
-  return dev.pos();
+  return (dev ? dev->pos() : offset);
 }
 
 bool Reader::seek(qint64 pos) {
-  return dev.seek(pos);
+  if (dev) {
+    return dev->seek(pos);
+  }
+  if (pos < 0 || pos > size) {
+    return false;
+  }
+  offset = pos;
+  return true;
 }
 
 bool Reader::atEnd() const {
-  return dev.atEnd();
+  return (dev ? dev->atEnd() : offset >= size);
 }
 
 bool Reader::peekList(std::initializer_list<unsigned char> list) {
   if (list.size() == 0) {
     return false;
   }
-  const QByteArray parr = dev.peek(list.size());
-  if (parr.size() != list.size()) {
-    return false;
+
+  const char *buf{nullptr};
+  QByteArray parr;
+  if (dev) {
+    parr = dev->peek(list.size());
+    if (parr.size() != list.size()) {
+      return false;
+    }
+    buf = parr.constData();
   }
+  else {
+    if (size - offset < (qint64) list.size()) {
+      return false;
+    }
+    buf = data + offset;
+  }
+
   int i{0};
   for (auto it = list.begin(); it != list.end(); it++, i++) {
-    if (*it != (unsigned char) parr[i]) {
+    if (*it != (unsigned char) buf[i]) {
       return false;
     }
   }
@@ -77,11 +146,35 @@ bool Reader::peekList(std::initializer_list<unsigned char> list) {
 template <typename T>
 T Reader::getUInt(bool *ok) {
   constexpr int num = sizeof(T);
-  QByteArray buf = dev.read(num);
-  if (buf.size() < num) {
+
+  // Decode straight from memory when reading a span. Like a device
+  // read, a short read still consumes the remaining bytes.
+  if (!dev) {
+    if (size - offset < num) {
+      offset = size;
+      failed = true;
+      if (ok) *ok = false;
+      return 0;
+    }
+    T res = decodeUInt<T>(data + offset);
+    offset += num;
+    if (ok) *ok = true;
+    return res;
+  }
+
+  char buf[num];
+  if (dev->read(buf, num) < num) {
+    failed = true;
     if (ok) *ok = false;
     return 0;
   }
+  if (ok) *ok = true;
+  return decodeUInt<T>(buf);
+}
+
+template <typename T>
+T Reader::decodeUInt(const char *buf) const {
+  constexpr int num = sizeof(T);
   T res{0};
   for (int i = 0; i < num; i++) {
     int j = i;
@@ -90,6 +183,5 @@ T Reader::getUInt(bool *ok) {
     }
     res += ((T) (unsigned char) buf[i]) << j * 8;
   }
-  if (ok) *ok = true;
   return res;
 }
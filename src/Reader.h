@@ -14,6 +14,13 @@ class Reader {
 public:
   Reader(QIODevice &dev, bool littleEndian = true);
 
+  /**
+   * Read directly from a span of memory, like a memory-mapped file,
+   * instead of a device. The integer getters decode straight from the
+   * bytes without allocating. The memory must outlive the reader.
+   */
+  Reader(const char *data, qint64 size, bool littleEndian = true);
+
   bool isLittleEndian() const { return littleEndian; }
   void setLittleEndian(bool little) { littleEndian = little; }
 
@@ -21,6 +28,9 @@ public:
   quint32 getUInt32(bool *ok = nullptr);
   quint64 getUInt64(bool *ok = nullptr);
 
+  // Unsigned LEB128 encoded value of variable length.
+  quint64 getULEB128(bool *ok = nullptr);
+
   char getChar(bool *ok = nullptr);
   unsigned char getUChar(bool *ok = nullptr);
   char peekChar(bool *ok = nullptr);
@@ -34,12 +44,21 @@ public:
 
   bool peekList(std::initializer_list<unsigned char> list);
 
+  // True if a read ran out of bytes since the last reset.
+  bool hasFailed() const { return failed; }
+  void resetFailed() { failed = false; }
+
 private:
   template <typename T>
   T getUInt(bool *ok = nullptr);
 
-  QIODevice &dev;
-  bool littleEndian;
+  template <typename T>
+  T decodeUInt(const char *buf) const;
+
+  QIODevice *dev;
+  const char *data;
+  qint64 size, offset;
+  bool littleEndian, failed;
 };
 
 #endif // BMOD_READER_H
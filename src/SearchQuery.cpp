@@ -0,0 +1,113 @@
+#include <QObject>
+#include <QStringList>
+
+#include "SearchQuery.h"
+
+namespace {
+  bool isLetter(ushort c) {
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+  }
+}
+
+bool SearchQuery::parse(const QString &str, Kind def, SearchQuery &query,
+                        QString *error) {
+  auto fail = [error](const QString &msg) {
+    if (error) *error = msg;
+    return false;
+  };
+
+  query = SearchQuery();
+  query.kind = def;
+
+  struct {
+    const char *prefix;
+    Kind kind;
+  } prefixes[] = {
+    {"hex:", Kind::Hex},
+    {"ascii:", Kind::Ascii},
+    {"utf16:", Kind::Utf16},
+    {"asm:", Kind::Mnemonic}
+  };
+
+  QString text = str;
+  for (const auto &p : prefixes) {
+    if (text.startsWith(p.prefix, Qt::CaseInsensitive)) {
+      query.kind = p.kind;
+      text = text.mid(QString(p.prefix).size());
+      break;
+    }
+  }
+
+  // Spaces are only kept inside text.
+  if (query.kind == Kind::Hex) {
+    text.remove(' ');
+  }
+  else {
+    text = text.trimmed();
+  }
+  if (text.isEmpty()) {
+    return fail(QObject::tr("Empty query"));
+  }
+  query.text = text;
+
+  switch (query.kind) {
+  case Kind::Hex: {
+    if (text.size() % 2 != 0) {
+      return fail(QObject::tr("Hex bytes must be two digits each"));
+    }
+    bool exact{false};
+    for (int i = 0; i < text.size(); i += 2) {
+      QString byte = text.mid(i, 2);
+      if (byte == "??") {
+        query.pattern += '\0';
+        query.mask += '\0';
+        continue;
+      }
+      bool ok;
+      int value = byte.toInt(&ok, 16);
+      if (!ok) {
+        return fail(QObject::tr("Invalid hex byte: %1").arg(byte));
+      }
+      query.pattern += char(value);
+      query.mask += char(0xFF);
+      exact = true;
+    }
+    if (!exact) {
+      return fail(QObject::tr("Pattern matches anything"));
+    }
+    break;
+  }
+
+  case Kind::Ascii:
+  case Kind::Utf16:
+    query.addText(text);
+    break;
+
+  case Kind::Mnemonic:
+    break;
+  }
+  return true;
+}
+
+void SearchQuery::addText(const QString &text) {
+  // Non-ASCII characters of ASCII text are matched as UTF-8.
+  if (kind == Kind::Ascii) {
+    QByteArray utf8 = text.toUtf8();
+    for (int i = 0; i < utf8.size(); i++) {
+      char c = utf8[i];
+      bool fold = isLetter((uchar) c);
+      pattern += (fold ? char(c & 0xDF) : c);
+      mask += char(fold ? 0xDF : 0xFF);
+    }
+    return;
+  }
+
+  foreach (const QChar &ch, text) {
+    ushort c = ch.unicode();
+    bool fold = isLetter(c);
+    pattern += (fold ? char(c & 0xDF) : char(c & 0xFF));
+    pattern += char(c >> 8);
+    mask += char(fold ? 0xDF : 0xFF);
+    mask += char(0xFF);
+  }
+}
@@ -0,0 +1,51 @@
+#ifndef BMOD_SEARCH_QUERY_H
+#define BMOD_SEARCH_QUERY_H
+
+#include <QString>
+#include <QByteArray>
+
+/**
+ * Search typed by the user, like "hex: 55 48 ?? e5".
+ *
+ * The prefix selects the kind: "hex:" for bytes where "??" matches any
+ * byte, "ascii:" and "utf16:" for text encoded as such, and "asm:" for
+ * text of the decoded instructions. Text is matched case-insensitively.
+ */
+class SearchQuery {
+public:
+  enum class Kind {
+    Hex,
+    Ascii,
+    Utf16, // Little-endian.
+    Mnemonic
+  };
+
+  /**
+   * Parse str as a query of kind def unless it has a prefix. Returns
+   * false with the reason in error if it is invalid.
+   */
+  static bool parse(const QString &str, Kind def, SearchQuery &query,
+                    QString *error = nullptr);
+
+  Kind getKind() const { return kind; }
+  QString getText() const { return text; }
+
+  /**
+   * Bytes to match for the byte kinds. A byte b of the data matches
+   * byte i if (b & mask[i]) == pattern[i], so 0x00 in the mask matches
+   * any byte and 0xDF matches an ASCII letter of either case.
+   */
+  const QByteArray &getPattern() const { return pattern; }
+  const QByteArray &getMask() const { return mask; }
+
+  bool isBytes() const { return kind != Kind::Mnemonic; }
+
+private:
+  void addText(const QString &text);
+
+  Kind kind;
+  QString text;
+  QByteArray pattern, mask;
+};
+
+#endif // BMOD_SEARCH_QUERY_H
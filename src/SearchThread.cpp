@@ -0,0 +1,22 @@
+#include "SearchThread.h"
+
+SearchThread::SearchThread(BinaryObjectPtr obj, SectionPtr sec,
+                           const SearchQuery &query, QObject *parent)
+  : CancellableThread(parent), obj{obj}, query{query}
+{
+  qRegisterMetaType<SearchHits>();
+
+  // Search a copy so the section can be edited meanwhile.
+  this->sec = SectionPtr(new Section(*sec));
+}
+
+void SearchThread::run() {
+  qint64 size = sec->getDataSize();
+  Searcher searcher(obj);
+  searcher.search(sec, query,
+                  [this, size](const SearchHits &result, qint64 pos) {
+                    if (isCancelled()) return false;
+                    emit hits(result, pos, size);
+                    return true;
+                  });
+}
@@ -0,0 +1,33 @@
+#ifndef BMOD_SEARCH_THREAD_H
+#define BMOD_SEARCH_THREAD_H
+
+#include "Section.h"
+#include "Searcher.h"
+#include "SearchQuery.h"
+#include "BinaryObject.h"
+#include "CancellableThread.h"
+
+/**
+ * Searches a section on a worker thread and emits the hits in batches
+ * as they are found.
+ */
+class SearchThread : public CancellableThread {
+  Q_OBJECT
+
+public:
+  SearchThread(BinaryObjectPtr obj, SectionPtr sec, const SearchQuery &query,
+               QObject *parent = nullptr);
+
+signals:
+  void hits(const SearchHits &hits, qint64 pos, qint64 size);
+
+protected:
+  void run();
+
+private:
+  BinaryObjectPtr obj;
+  SectionPtr sec;
+  SearchQuery query;
+};
+
+#endif // BMOD_SEARCH_THREAD_H
@@ -0,0 +1,108 @@
+#include <cstring>
+
+#include "Searcher.h"
+#include "asm/Disassembler.h"
+
+namespace {
+  // Bytes read from the section at a time, and hits reported at a time.
+  const int chunkSize = 1024 * 1024;
+  const int batchSize = 256;
+
+  // Bytes of instructions decoded between progress reports.
+  const int progressStep = 64 * 1024;
+
+  bool matches(const char *data, const char *pattern, const char *mask,
+               int len) {
+    for (int i = 0; i < len; i++) {
+      if ((data[i] & mask[i]) != pattern[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+}
+
+Searcher::Searcher(BinaryObjectPtr obj) : obj{obj} { }
+
+bool Searcher::search(SectionPtr sec, const SearchQuery &query,
+                      HitFunc func) {
+  if (query.isBytes()) {
+    return searchBytes(sec, query, func);
+  }
+  return searchMnemonic(sec, query, func);
+}
+
+bool Searcher::searchBytes(SectionPtr sec, const SearchQuery &query,
+                           HitFunc func) {
+  const QByteArray &pattern = query.getPattern(), &mask = query.getMask();
+  const char *pat = pattern.constData(), *msk = mask.constData();
+  int len = pattern.size(), size = sec->getDataSize();
+
+  // Skip ahead with memchr() to the first byte that must match exactly.
+  int anchor{-1};
+  for (int i = 0; i < len; i++) {
+    if ((uchar) msk[i] == 0xFF) {
+      anchor = i;
+      break;
+    }
+  }
+
+  SearchHits hits;
+  for (int pos = 0; pos < size; pos += chunkSize) {
+    // Read past the end of the chunk to find matches starting in it.
+    int end = qMin(pos + chunkSize, size),
+      readLen = qMin(end - pos + len - 1, size - pos),
+      last = qMin(end - pos, readLen - len + 1);
+    QByteArray data = sec->read(pos, readLen);
+    const char *ptr = data.constData();
+
+    for (int i = 0; i < last; i++) {
+      if (anchor != -1) {
+        const void *found =
+          memchr(ptr + i + anchor, pat[anchor], last - i);
+        if (!found) break;
+        i = (const char*) found - ptr - anchor;
+      }
+      if (!matches(ptr + i, pat, msk, len)) {
+        continue;
+      }
+
+      hits << SearchHit{quint32(pos + i), quint32(len)};
+      if (hits.size() == batchSize) {
+        if (!func(hits, pos + i)) return false;
+        hits.resize(0);
+      }
+    }
+
+    if (!func(hits, end)) return false;
+    hits.resize(0);
+  }
+  return true;
+}
+
+bool Searcher::searchMnemonic(SectionPtr sec, const SearchQuery &query,
+                              HitFunc func) {
+  QString text = query.getText(), line;
+  Disassembler dis(obj);
+  SearchHits hits;
+  qint64 nextReport{progressStep};
+  bool cancelled{false};
+  dis.visit(sec, [&](const Disassembly &window, int index) {
+      quint32 offset = window.getOffset(index);
+      dis.render(window, index, line);
+      if (line.contains(text, Qt::CaseInsensitive)) {
+        hits << SearchHit{offset, window.getLength(index)};
+      }
+      if (hits.size() == batchSize || offset >= nextReport) {
+        nextReport = offset + progressStep;
+        if (!func(hits, offset)) {
+          cancelled = true;
+          return false;
+        }
+        hits.resize(0);
+      }
+      return true;
+    });
+  if (cancelled) return false;
+  return func(hits, sec->getDataSize());
+}
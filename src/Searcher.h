@@ -0,0 +1,50 @@
+#ifndef BMOD_SEARCHER_H
+#define BMOD_SEARCHER_H
+
+#include <QVector>
+#include <QMetaType>
+
+#include <functional>
+
+#include "Section.h"
+#include "SearchQuery.h"
+#include "BinaryObject.h"
+
+struct SearchHit {
+  quint32 offset; // Into section data.
+  quint32 length;
+};
+
+typedef QVector<SearchHit> SearchHits;
+
+/**
+ * Finds the matches of a query in the data of a section. Bytes are
+ * searched in chunks read from the section, so matches that cross line
+ * or page boundaries are found, and mnemonic text is matched against
+ * instructions as they are decoded.
+ */
+class Searcher {
+public:
+  /**
+   * Receives the next hits in order of offset and the number of bytes
+   * searched so far. It is also called without hits as the search
+   * progresses. Return false to cancel.
+   */
+  typedef std::function<bool(const SearchHits &hits, qint64 pos)> HitFunc;
+
+  Searcher(BinaryObjectPtr obj);
+
+  // Returns false if cancelled.
+  bool search(SectionPtr sec, const SearchQuery &query, HitFunc func);
+
+private:
+  bool searchBytes(SectionPtr sec, const SearchQuery &query, HitFunc func);
+  bool searchMnemonic(SectionPtr sec, const SearchQuery &query,
+                      HitFunc func);
+
+  BinaryObjectPtr obj;
+};
+
+Q_DECLARE_METATYPE(SearchHits)
+
+#endif // BMOD_SEARCHER_H
@@ -1,23 +1,113 @@
+#include <cstring>
+
 #include "Section.h"
 
+const int Section::pageSize;
+
 Section::Section(SectionType type, const QString &name, quint64 addr,
                  quint64 size, quint32 offset)
-  : type{type}, name{name}, addr{addr}, size{size}, offset{offset}
+  : type{type}, name{name}, addr{addr}, size{size}, offset{offset},
+  loaded{true}
 { }
 
+QByteArray Section::getData() const {
+  if (pages.empty()) {
+    return getBase();
+  }
+  return read(0, getDataSize());
+}
+
+void Section::setData(const QByteArray &data) {
+  this->data = data;
+  loaded = true;
+  mappedFile.reset();
+  pages.clear();
+}
+
+QByteArray Section::read(int pos, int len) const {
+  const QByteArray &base = getBase();
+  if (pos < 0 || pos >= base.size() || len <= 0) {
+    return QByteArray();
+  }
+  len = qMin(len, base.size() - pos);
+
+  int end = pos + len;
+  auto it = pages.lower_bound(pos / pageSize);
+  if (it == pages.end() || it->first * pageSize >= end) {
+    return QByteArray::fromRawData(base.constData() + pos, len);
+  }
+
+  QByteArray res(base.constData() + pos, len);
+  for (; it != pages.end() && it->first * pageSize < end; ++it) {
+    int pageStart = it->first * pageSize,
+      from = qMax(pos, pageStart),
+      to = qMin(end, pageStart + it->second.size());
+    std::memcpy(res.data() + from - pos,
+                it->second.constData() + from - pageStart, to - from);
+  }
+  return res;
+}
+
+void Section::setMappedFile(MappedFilePtr file) {
+  mappedFile = file;
+  data.clear();
+  loaded = (file == nullptr);
+  pages.clear();
+}
+
 void Section::setSubData(const QByteArray &subData, int pos) {
-  if (pos < 0 || pos > data.size() - 1) {
+  const QByteArray &base = getBase();
+  if (pos < 0 || pos > base.size() - 1) {
     return;
   }
-  data.replace(pos, subData.size(), subData);
+  int len = qMin(subData.size(), base.size() - pos), end = pos + len;
+
+  for (int idx = pos / pageSize; idx * pageSize < end; idx++) {
+    int pageStart = idx * pageSize;
+    auto it = pages.find(idx);
+    if (it == pages.end()) {
+      int pageLen = qMin(pageSize, base.size() - pageStart);
+      it = pages.emplace(idx, QByteArray(base.constData() + pageStart,
+                                         pageLen)).first;
+    }
+
+    int from = qMax(pos, pageStart),
+      to = qMin(end, pageStart + it->second.size());
+    std::memcpy(it->second.data() + from - pageStart,
+                subData.constData() + from - pos, to - from);
+  }
+
   modified = QDateTime::currentDateTime();
+  modifiedRegions.add(pos, len);
+}
+
+void Section::restoreModifiedRegions(const IntervalSet &regions) {
+  modifiedRegions = regions;
+  foreach (const auto &region, committedRegions.getRegions()) {
+    modifiedRegions.add(region.first, region.second);
+  }
 
-  QPair<int, int> region(pos, subData.size());
-  if (!modifiedRegions.contains(region)) {
-    modifiedRegions << region;
+  for (auto it = pages.begin(); it != pages.end(); ) {
+    int pageStart = it->first * pageSize;
+    if (modifiedRegions.intersects(pageStart,
+                                   pageStart + it->second.size())) {
+      ++it;
+    }
+    else {
+      it = pages.erase(it);
+    }
   }
+  modified = QDateTime::currentDateTime();
 }
 
-const QList<QPair<int, int>> &Section::getModifiedRegions() const {
-  return modifiedRegions;
+const QByteArray &Section::getBase() const {
+  if (!loaded) {
+    loaded = true;
+    qint64 avail = mappedFile->getSize() - (qint64) offset;
+    if (avail > 0) {
+      data = QByteArray::fromRawData(mappedFile->getData() + offset,
+                                     qMin((qint64) size, avail));
+    }
+  }
+  return data;
 }
@@ -7,8 +7,11 @@
 #include <QDateTime>
 #include <QByteArray>
 
+#include <map>
 #include <memory>
 
+#include "MappedFile.h"
+#include "IntervalSet.h"
 #include "SectionType.h"
 
 class Section;
@@ -25,21 +28,71 @@ public:
   quint64 getSize() const { return size; }
   quint32 getOffset() const { return offset; }
 
-  const QByteArray &getData() const { return data; }
-  void setData(const QByteArray &data) { this->data = data; }
+  // Size of the data, which is less than getSize() if the section
+  // extends past the end of the file.
+  int getDataSize() const { return getBase().size(); }
 
+  /**
+   * Merged view of the original bytes and the edited pages. Without
+   * edits this is the original data, and after edits a copy of the whole
+   * section that isn't kept, so prefer read() for parts of large
+   * sections.
+   */
+  QByteArray getData() const;
+  void setData(const QByteArray &data);
+
+  /**
+   * Read len bytes at pos with the edits applied. If no edited page
+   * overlaps the range the result refers to the original bytes without
+   * copying, and it stays valid as long as the section's data is not
+   * replaced.
+   */
+  QByteArray read(int pos, int len) const;
+
+  /**
+   * Load the data on first access from the section's offset in the
+   * mapped file. The bytes are not copied until they are modified, and
+   * the section keeps the mapping alive.
+   */
+  void setMappedFile(MappedFilePtr file);
+  bool isLoaded() const { return loaded; }
+
+  /**
+   * Edit the bytes at pos. The original data is left untouched and
+   * each 4 KiB page being written to is copied on first write, so the
+   * cost of an edit is proportional to the pages it touches.
+   */
   void setSubData(const QByteArray &subData, int pos);
   bool isModified() const { return !modifiedRegions.isEmpty(); }
   QDateTime modifiedWhen() const { return modified; }
-  const QList<QPair<int, int>> &getModifiedRegions() const;
+  const IntervalSet &getModifiedRegions() const { return modifiedRegions; }
+
+  /**
+   * Put back the modified regions from before the edits that were just
+   * reverted. Pages outside them hold the original bytes again and are
+   * dropped. Regions written to the file stay modified.
+   */
+  void restoreModifiedRegions(const IntervalSet &regions);
+
+  // The modified regions were written to the file.
+  void setCommitted() { committedRegions = modifiedRegions; }
 
 private:
+  static const int pageSize = 4096;
+
+  const QByteArray &getBase() const;
+
   SectionType type;
   QString name;
   quint64 addr, size;
   quint32 offset;
-  QByteArray data;
-  QList<QPair<int, int>> modifiedRegions;
+  mutable QByteArray data;
+  mutable bool loaded;
+  MappedFilePtr mappedFile;
+  IntervalSet modifiedRegions, committedRegions;
+
+  // Page index to the edited copy of that page.
+  std::map<int, QByteArray> pages;
   QDateTime modified;
 };
 
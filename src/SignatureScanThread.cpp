@@ -0,0 +1,42 @@
+#include <vector>
+
+#include "Parallel.h"
+#include "SignatureScanThread.h"
+
+SignatureScanThread::SignatureScanThread(const SignatureScanner &scanner,
+                                         const QList<BinaryObjectPtr> &objects,
+                                         QObject *parent)
+  : CancellableThread(parent), scanner{scanner}
+{
+  qRegisterMetaType<SignatureHits>();
+
+  // Scan copies so the sections can be edited meanwhile.
+  foreach (const auto obj, objects) {
+    foreach (const auto sec, obj->getSections()) {
+      jobs << qMakePair(obj, SectionPtr(new Section(*sec)));
+    }
+  }
+}
+
+void SignatureScanThread::run() {
+  // Scan as many sections at once as there are threads and emit their
+  // hits in order before the next ones.
+  int total = jobs.size(), step = Parallel::getThreadCount();
+  for (int first = 0; first < total; first += step) {
+    if (isCancelled()) return;
+
+    int count = qMin(step, total - first);
+    std::vector<SignatureHits> results(count);
+    Parallel::run(count, [&](int i) {
+        const auto &job = jobs[first + i];
+        scanner.scan(job.first, job.second, results[i]);
+      }, step);
+
+    SignatureHits batch;
+    for (const auto &res : results) {
+      batch << res;
+    }
+    if (isCancelled()) return;
+    emit hits(batch, first + count, total);
+  }
+}
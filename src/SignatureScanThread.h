@@ -0,0 +1,36 @@
+#ifndef BMOD_SIGNATURE_SCAN_THREAD_H
+#define BMOD_SIGNATURE_SCAN_THREAD_H
+
+#include <QList>
+#include <QPair>
+
+#include "Section.h"
+#include "BinaryObject.h"
+#include "SignatureScanner.h"
+#include "CancellableThread.h"
+
+/**
+ * Scans all sections of the objects for signatures on a worker thread
+ * and emits the hits in batches, in order of object, section and
+ * offset, as they are found.
+ */
+class SignatureScanThread : public CancellableThread {
+  Q_OBJECT
+
+public:
+  SignatureScanThread(const SignatureScanner &scanner,
+                      const QList<BinaryObjectPtr> &objects,
+                      QObject *parent = nullptr);
+
+signals:
+  void hits(const SignatureHits &hits, int sections, int total);
+
+protected:
+  void run();
+
+private:
+  SignatureScanner scanner;
+  QList<QPair<BinaryObjectPtr, SectionPtr>> jobs;
+};
+
+#endif // BMOD_SIGNATURE_SCAN_THREAD_H
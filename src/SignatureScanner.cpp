@@ -0,0 +1,212 @@
+#include <QFile>
+#include <QObject>
+#include <QStringList>
+
+#include <algorithm>
+
+#include "Parallel.h"
+#include "SearchQuery.h"
+#include "SignatureScanner.h"
+
+namespace {
+  // Bytes too frequent in code and data to anchor on if avoidable.
+  int commonness(uchar b) {
+    switch (b) {
+    case 0x00:
+    case 0xFF:
+      return 2;
+
+    case 0x48: // REX.W
+    case 0x89: // mov
+    case 0x8B: // mov
+    case 0x90: // nop
+    case 0xCC: // int3
+      return 1;
+
+    default:
+      return 0;
+    }
+  }
+}
+
+SignatureScanner::SignatureScanner()
+  : byteAnchors(256), candidates(65536 / 64, 0)
+{ }
+
+bool SignatureScanner::addSignature(const QString &name, const QString &bytes,
+                                    QString *error) {
+  auto fail = [error, &name](const QString &msg) {
+    if (error) *error = QString("%1: %2").arg(name).arg(msg);
+    return false;
+  };
+
+  SearchQuery query;
+  QString err;
+  if (!SearchQuery::parse(bytes, SearchQuery::Kind::Hex, query, &err)) {
+    return fail(err);
+  }
+  if (query.getKind() != SearchQuery::Kind::Hex) {
+    return fail(QObject::tr("Signatures must be hex bytes"));
+  }
+
+  Signature sig{name, query.getPattern(), query.getMask()};
+  const QByteArray &pat = sig.pattern, &mask = sig.mask;
+
+  // Anchor on the least common pair of exact bytes, or else on the
+  // first exact byte.
+  int pos{-1}, best{0}, single{-1};
+  for (int i = 0; i < pat.size(); i++) {
+    if ((uchar) mask[i] != 0xFF) continue;
+    if (single == -1) single = i;
+    if (i + 1 == pat.size() || (uchar) mask[i + 1] != 0xFF) continue;
+    int score = commonness(pat[i]) + commonness(pat[i + 1]);
+    if (pos == -1 || score < best) {
+      pos = i;
+      best = score;
+    }
+  }
+
+  Anchor anchor{signatures.size(), pos != -1 ? pos : single};
+  uchar first = pat[anchor.pos];
+  if (pos != -1) {
+    quint16 pair = first | ((uchar) pat[pos + 1] << 8);
+    pairAnchors[pair] << anchor;
+    candidates[pair / 64] |= quint64(1) << (pair % 64);
+  }
+  else {
+    byteAnchors[first] << anchor;
+    for (int second = 0; second < 256; second++) {
+      quint16 pair = first | (second << 8);
+      candidates[pair / 64] |= quint64(1) << (pair % 64);
+    }
+  }
+
+  signatures << sig;
+  return true;
+}
+
+bool SignatureScanner::parse(const QString &text, QString *error) {
+  QStringList lines = text.split('\n');
+  for (int i = 0; i < lines.size(); i++) {
+    QString line = lines[i].trimmed();
+    if (line.isEmpty() || line.startsWith('#')) {
+      continue;
+    }
+
+    // Signatures without a name are named by their bytes.
+    QString name = line, bytes = line;
+    int eq = line.indexOf('=');
+    if (eq != -1) {
+      name = line.left(eq).trimmed();
+      bytes = line.mid(eq + 1).trimmed();
+    }
+
+    QString err;
+    if (!addSignature(name, bytes, &err)) {
+      if (error) *error = QObject::tr("Line %1: %2").arg(i + 1).arg(err);
+      return false;
+    }
+  }
+  return true;
+}
+
+bool SignatureScanner::load(const QString &file, QString *error) {
+  QFile f(file);
+  if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    if (error) *error = QObject::tr("Could not read %1").arg(file);
+    return false;
+  }
+  return parse(QString::fromUtf8(f.readAll()), error);
+}
+
+void SignatureScanner::scan(BinaryObjectPtr obj, SectionPtr sec,
+                            QVector<Hit> &hits) const {
+  int size = sec->getDataSize();
+  if (signatures.isEmpty() || size == 0) {
+    return;
+  }
+
+  QByteArray data = sec->read(0, size);
+  const char *ptr = data.constData();
+  int firstHit = hits.size(), start;
+
+  // Verify the anchors starting at pos.
+  auto check = [&](int pos) {
+    uchar b = ptr[pos];
+    for (const auto &anchor : byteAnchors[b]) {
+      if (verify(ptr, size, pos, anchor, start)) {
+        hits << Hit{obj, sec, quint32(start), anchor.signature};
+      }
+    }
+    if (pos + 1 == size) return;
+    quint16 pair = b | ((uchar) ptr[pos + 1] << 8);
+    auto it = pairAnchors.constFind(pair);
+    if (it == pairAnchors.constEnd()) return;
+    for (const auto &anchor : *it) {
+      if (verify(ptr, size, pos, anchor, start)) {
+        hits << Hit{obj, sec, quint32(start), anchor.signature};
+      }
+    }
+  };
+
+  // One lookup in the 8 KiB table per byte, however many signatures.
+  const quint64 *bits = candidates.data();
+  const uchar *bytes = reinterpret_cast<const uchar*>(ptr);
+  for (int pos = 0; pos + 1 < size; pos++) {
+    quint16 pair = bytes[pos] | (bytes[pos + 1] << 8);
+    if (bits[pair / 64] & (quint64(1) << (pair % 64))) {
+      check(pos);
+    }
+  }
+  if (!byteAnchors[bytes[size - 1]].isEmpty()) {
+    check(size - 1);
+  }
+
+  // Anchors are at different positions of the signatures.
+  std::sort(hits.begin() + firstHit, hits.end(),
+            [](const Hit &a, const Hit &b) {
+              return a.offset < b.offset ||
+                (a.offset == b.offset && a.signature < b.signature);
+            });
+}
+
+QVector<SignatureScanner::Hit>
+SignatureScanner::scan(const QList<BinaryObjectPtr> &objects,
+                       int threads) const {
+  QList<QPair<BinaryObjectPtr, SectionPtr>> jobs;
+  foreach (const auto obj, objects) {
+    foreach (const auto sec, obj->getSections()) {
+      jobs << qMakePair(obj, sec);
+    }
+  }
+
+  std::vector<QVector<Hit>> results(jobs.size());
+  Parallel::run(jobs.size(), [&](int i) {
+      scan(jobs[i].first, jobs[i].second, results[i]);
+    }, threads);
+
+  QVector<Hit> hits;
+  for (const auto &res : results) {
+    hits << res;
+  }
+  return hits;
+}
+
+bool SignatureScanner::verify(const char *data, int size, int pos,
+                              const Anchor &anchor, int &start) const {
+  const auto &sig = signatures[anchor.signature];
+  int len = sig.pattern.size();
+  start = pos - anchor.pos;
+  if (start < 0 || start + len > size) {
+    return false;
+  }
+
+  const char *ptr = data + start, *pat = sig.pattern.constData(),
+    *mask = sig.mask.constData();
+  for (int i = 0; i < len; i++) {
+    if ((ptr[i] & mask[i]) != pat[i]) {
+      return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,92 @@
+#ifndef BMOD_SIGNATURE_SCANNER_H
+#define BMOD_SIGNATURE_SCANNER_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QVector>
+#include <QMetaType>
+#include <QByteArray>
+
+#include <vector>
+
+#include "Section.h"
+#include "BinaryObject.h"
+
+/**
+ * Finds many byte signatures at once in the sections of binary objects.
+ *
+ * A signature is hex bytes where "??" matches any byte, like
+ * "55 48 89 e5 ?? 83". Each signature is anchored at a pair of exact
+ * bytes, and the data is scanned once looking up every pair of bytes
+ * in a table of all anchors, so the cost hardly grows with the number
+ * of signatures.
+ */
+class SignatureScanner {
+public:
+  struct Hit {
+    BinaryObjectPtr object;
+    SectionPtr section;
+    quint32 offset; // Into section data.
+    int signature;
+  };
+
+  SignatureScanner();
+
+  bool addSignature(const QString &name, const QString &bytes,
+                    QString *error = nullptr);
+
+  /**
+   * Add the signatures of text with one "name = bytes" per line. Empty
+   * lines and lines starting with # are ignored.
+   */
+  bool parse(const QString &text, QString *error = nullptr);
+  bool load(const QString &file, QString *error = nullptr);
+
+  int getSignatureCount() const { return signatures.size(); }
+  QString getName(int signature) const { return signatures[signature].name; }
+  int getLength(int signature) const {
+    return signatures[signature].pattern.size();
+  }
+
+  // Append the hits in the data of the section in order of offset.
+  void scan(BinaryObjectPtr obj, SectionPtr sec, QVector<Hit> &hits) const;
+
+  /**
+   * Scan all sections of the objects on a pool of threads, see
+   * Parallel. Hits are in order of object, section and offset.
+   */
+  QVector<Hit> scan(const QList<BinaryObjectPtr> &objects,
+                    int threads = 0) const;
+
+private:
+  struct Signature {
+    QString name;
+    QByteArray pattern, mask;
+  };
+
+  struct Anchor {
+    int signature;
+    int pos; // Of the anchor in the signature.
+  };
+
+  bool verify(const char *data, int size, int pos, const Anchor &anchor,
+              int &start) const;
+
+  QVector<Signature> signatures;
+
+  // Anchors by the pair of bytes, low byte first, or by the byte for
+  // signatures without two exact bytes in a row.
+  QHash<quint16, QVector<Anchor>> pairAnchors;
+  std::vector<QVector<Anchor>> byteAnchors;
+
+  // Bit per pair of bytes, low byte first, that might start an anchor.
+  // All pairs starting with the byte of a byte anchor are set.
+  std::vector<quint64> candidates;
+};
+
+typedef QVector<SignatureScanner::Hit> SignatureHits;
+
+Q_DECLARE_METATYPE(SignatureHits)
+
+#endif // BMOD_SIGNATURE_SCANNER_H
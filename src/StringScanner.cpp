@@ -0,0 +1,205 @@
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#include "Parallel.h"
+#include "StringScanner.h"
+
+namespace {
+  // Bytes scanned by a thread at a time. Even for UTF-16.
+  const int chunkSize = 256 * 1024;
+
+  int chunkCount(int size) {
+    return qMax(1, (size + chunkSize - 1) / chunkSize);
+  }
+
+  // Printable ASCII and the whitespace of text.
+  struct TextTable {
+    TextTable() {
+      for (int c = 0; c < 256; c++) {
+        text[c] = (c >= 32 && c <= 126) || c == '\t' || c == '\n' ||
+          c == '\r';
+      }
+    }
+
+    bool text[256];
+  };
+
+  const bool *textTable() {
+    static const TextTable table;
+    return table.text;
+  }
+
+  // Runs of text starting in the chunk. A run crossing the end of it is
+  // followed to its end, and one crossing the start belongs to the
+  // previous chunk.
+  void findAscii(const char *data, int size, int start, int end,
+                 int minLength, StringScanner::Spans &out) {
+    const bool *isText = textTable();
+    int pos = start;
+    if (pos > 0 && isText[(uchar) data[pos - 1]]) {
+      while (pos < size && isText[(uchar) data[pos]]) pos++;
+    }
+    while (pos < end) {
+      if (!isText[(uchar) data[pos]]) {
+        pos++;
+        continue;
+      }
+      int first = pos;
+      while (pos < size && isText[(uchar) data[pos]]) pos++;
+      if (pos - first >= minLength) {
+        out << StringScanner::Span{quint32(first), quint32(pos - first),
+            StringScanner::Encoding::Utf8};
+      }
+    }
+  }
+
+  // Like findAscii() with characters of an ASCII byte followed by NUL.
+  void findUtf16(const char *data, int size, int start, int end,
+                 int minLength, StringScanner::Spans &out) {
+    const bool *isText = textTable();
+    auto isChar = [data, size, isText](int pos) {
+      return pos + 1 < size && data[pos + 1] == 0 &&
+        isText[(uchar) data[pos]];
+    };
+
+    int pos = start;
+    if (pos > 1 && isChar(pos - 2)) {
+      while (isChar(pos)) pos += 2;
+    }
+    while (pos < end) {
+      if (!isChar(pos)) {
+        pos += 2;
+        continue;
+      }
+      int first = pos;
+      while (isChar(pos)) pos += 2;
+      if ((pos - first) / 2 >= minLength) {
+        out << StringScanner::Span{quint32(first), quint32(pos - first),
+            StringScanner::Encoding::Utf16};
+      }
+    }
+  }
+}
+
+StringScanner::Spans StringScanner::split(const QByteArray &data,
+                                          int threads) {
+  int size = data.size(), chunks = chunkCount(size);
+  const char *ptr = data.constData();
+
+  // Find the NULs of each chunk with memchr(), which is vectorized.
+  std::vector<QVector<quint32>> nuls(chunks);
+  Parallel::run(chunks, [&](int i) {
+      int pos = i * chunkSize, end = qMin(pos + chunkSize, size);
+      auto &out = nuls[i];
+      while (pos < end) {
+        const void *nul = memchr(ptr + pos, 0, end - pos);
+        if (!nul) break;
+        pos = static_cast<const char*>(nul) - ptr;
+        out << pos++;
+      }
+    }, threads);
+
+  int count{0};
+  for (const auto &list : nuls) {
+    count += list.size();
+  }
+
+  Spans spans;
+  spans.reserve(count);
+  quint32 start{0};
+  for (const auto &list : nuls) {
+    foreach (quint32 nul, list) {
+      spans << Span{start, nul - start + 1, Encoding::Utf8};
+      start = nul + 1;
+    }
+  }
+  return spans;
+}
+
+StringScanner::Spans StringScanner::find(const QByteArray &data,
+                                         int minLength, bool utf16,
+                                         int threads) {
+  // Single characters of UTF-16 text would be found as ASCII too.
+  minLength = qMax(minLength, 2);
+
+  int size = data.size(), chunks = chunkCount(size);
+  const char *ptr = data.constData();
+
+  std::vector<Spans> results(chunks);
+  Parallel::run(chunks, [&](int i) {
+      int start = i * chunkSize, end = qMin(start + chunkSize, size);
+      auto &out = results[i];
+      findAscii(ptr, size, start, end, minLength, out);
+      if (utf16) {
+        findUtf16(ptr, size, start, end, minLength, out);
+        std::sort(out.begin(), out.end(), [](const Span &a, const Span &b) {
+            return a.offset < b.offset;
+          });
+      }
+    }, threads);
+
+  Spans spans;
+  for (const auto &res : results) {
+    spans << res;
+  }
+  return spans;
+}
+
+bool StringScanner::isBoundary(const QByteArray &data, int pos,
+                               bool terminated) {
+  const char *ptr = data.constData();
+  if (terminated) {
+    return pos > 0 && pos <= data.size() && ptr[pos - 1] == 0;
+  }
+
+  // UTF-16 strings are at even offsets. A byte that is neither text nor
+  // NUL ends any string, and so does a NUL character.
+  if (pos < 2 || pos > data.size() || pos % 2 != 0) {
+    return false;
+  }
+  uchar c = ptr[pos - 1];
+  return (c == 0 ? ptr[pos - 2] == 0 : !textTable()[c]);
+}
+
+QString StringScanner::toString(const QByteArray &bytes, Encoding encoding) {
+  const char *ptr = bytes.constData();
+  int len = getLength(bytes, encoding);
+  QString str;
+  if (encoding == Encoding::Utf16) {
+    str.resize(len);
+    for (int i = 0; i < len; i++) {
+      str[i] = QChar(ushort((uchar) ptr[2 * i] |
+                            ((uchar) ptr[2 * i + 1] << 8)));
+    }
+  }
+  else {
+    str = QString::fromUtf8(ptr, len);
+  }
+
+  // Most strings have nothing to escape.
+  foreach (const QChar &c, str) {
+    if (c == '\n' || c == '\t' || c == '\r') {
+      return str.replace("\n", "\\n").replace("\t", "\\t")
+        .replace("\r", "\\r");
+    }
+  }
+  return str;
+}
+
+int StringScanner::getLength(const QByteArray &bytes, Encoding encoding) {
+  const char *ptr = bytes.constData();
+  if (encoding == Encoding::Utf16) {
+    int len = bytes.size() / 2;
+    if (len > 0 && ptr[2 * len - 2] == 0 && ptr[2 * len - 1] == 0) {
+      len--;
+    }
+    return len;
+  }
+
+  int len = bytes.size();
+  if (len > 0 && ptr[len - 1] == 0) {
+    len--;
+  }
+  return len;
+}
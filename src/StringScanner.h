@@ -0,0 +1,63 @@
+#ifndef BMOD_STRING_SCANNER_H
+#define BMOD_STRING_SCANNER_H
+
+#include <QString>
+#include <QVector>
+#include <QByteArray>
+
+/**
+ * Finds the strings of section data as spans of offset and length, so
+ * nothing is decoded until a string is shown. Large data is scanned in
+ * chunks on a pool of threads, see Parallel.
+ */
+class StringScanner {
+public:
+  enum class Encoding : quint8 {
+    Utf8,
+    Utf16 // Little-endian.
+  };
+
+  struct Span {
+    quint32 offset; // Into the data.
+    quint32 length; // In bytes, including the NUL if terminated.
+    Encoding encoding;
+  };
+
+  typedef QVector<Span> Spans;
+
+  /**
+   * Split NUL-terminated strings, like of __cstring, so each byte up to
+   * the last NUL belongs to exactly one span.
+   */
+  static Spans split(const QByteArray &data, int threads = 0);
+
+  /**
+   * Runs of at least minLength printable ASCII characters in any data,
+   * and of UTF-16 characters in the ASCII range at even offsets if
+   * utf16. Spans don't include a terminator.
+   */
+  static Spans find(const QByteArray &data, int minLength, bool utf16 = true,
+                    int threads = 0);
+
+  /**
+   * Whether no string of split(), if terminated, or else of find()
+   * crosses offset pos of data, judging by the two bytes before it.
+   * The data must start at an even offset of the section. The strings
+   * on either side of a boundary can be found separately.
+   */
+  static bool isBoundary(const QByteArray &data, int pos, bool terminated);
+
+  /**
+   * Text of the bytes of a span without the terminator, with newlines,
+   * tabs and carriage returns escaped.
+   */
+  static QString toString(const QByteArray &bytes, Encoding encoding);
+
+  /**
+   * Length of the bytes of a span without the terminator and without
+   * decoding them, in bytes for UTF-8 and in characters for UTF-16.
+   */
+  static int getLength(const QByteArray &bytes, Encoding encoding);
+};
+
+#endif // BMOD_STRING_SCANNER_H
@@ -1,10 +1,42 @@
+#include <algorithm>
+
 #include "SymbolTable.h"
 
 void SymbolTable::addSymbol(const SymbolEntry &entry) {
   entries << entry;
+  indexed = false;
+}
+
+void SymbolTable::buildIndex() {
+  index.clear();
+  index.reserve(entries.size());
+  for (int i = 0; i < entries.size(); i++) {
+    if (!entries[i].getString().isEmpty()) {
+      index << i;
+    }
+  }
+
+  // Stable so the first of several entries with the same value wins,
+  // like with the linear scan.
+  std::stable_sort(index.begin(), index.end(), [this](int a, int b) {
+      return entries[a].getValue() < entries[b].getValue();
+    });
+  indexed = true;
 }
 
 bool SymbolTable::getString(quint64 value, QString &str) const {
+  if (indexed) {
+    auto it = std::lower_bound(index.begin(), index.end(), value,
+                               [this](int a, quint64 v) {
+                                 return entries[a].getValue() < v;
+                               });
+    if (it == index.end() || entries[*it].getValue() != value) {
+      return false;
+    }
+    str = entries[*it].getString();
+    return true;
+  }
+
   foreach (const auto &entry, entries) {
     if (entry.getValue() == value) {
       const auto &s  = entry.getString();
@@ -15,3 +47,49 @@ bool SymbolTable::getString(quint64 value, QString &str) const {
   }
   return false;
 }
+
+bool SymbolTable::getEnclosingString(quint64 value, QString &str,
+                                     quint64 *start) const {
+  if (!indexed) {
+    // Find the closest preceding named entry.
+    const SymbolEntry *best{nullptr};
+    foreach (const auto &entry, entries) {
+      if (entry.getString().isEmpty() || entry.getValue() > value) continue;
+      if (!best || entry.getValue() > best->getValue()) {
+        best = &entry;
+      }
+    }
+    if (!best) return false;
+    str = best->getString();
+    if (start) *start = best->getValue();
+    return true;
+  }
+
+  auto it = std::upper_bound(index.begin(), index.end(), value,
+                             [this](quint64 v, int a) {
+                               return v < entries[a].getValue();
+                             });
+  if (it == index.begin()) {
+    return false;
+  }
+
+  // Go back to the first entry of the greatest value not above value.
+  --it;
+  quint64 found = entries[*it].getValue();
+  while (it != index.begin() && entries[*(it - 1)].getValue() == found) {
+    --it;
+  }
+  str = entries[*it].getString();
+  if (start) *start = found;
+  return true;
+}
+
+bool SymbolTable::getValue(const QString &str, quint64 &value) const {
+  foreach (const auto &entry, entries) {
+    if (entry.getString() == str) {
+      value = entry.getValue();
+      return true;
+    }
+  }
+  return false;
+}
@@ -2,6 +2,7 @@
 #define BMOD_SYMBOL_TABLE_H
 
 #include <QList>
+#include <QVector>
 #include <QString>
 
 class SymbolEntry {
@@ -27,14 +28,44 @@ private:
 
 class SymbolTable {
 public:
+  SymbolTable() : indexed{false} { }
+
   void addSymbol(const SymbolEntry &entry);
-  QList<SymbolEntry> &getSymbols() { return entries; }  
+
+  // Invalidates the index because the entries might be changed.
+  QList<SymbolEntry> &getSymbols() { indexed = false; return entries; }
   const QList<SymbolEntry> &getSymbols() const { return entries; }
 
+  /**
+   * Sort the named entries by value so lookups are binary searches
+   * instead of linear scans. Call when the strings have been merged
+   * into the entries.
+   */
+  void buildIndex();
+  bool isIndexed() const { return indexed; }
+
   bool getString(quint64 value, QString &str) const;
 
+  /**
+   * Get the string of the entry with the greatest value less than or
+   * equal to the value, i.e. the function enclosing an address. The
+   * value of that entry is put into start if given.
+   */
+  bool getEnclosingString(quint64 value, QString &str,
+                          quint64 *start = nullptr) const;
+
+  /**
+   * Get the value of the first entry with the string. Symbols are
+   * looked up linearly since lookups by name are rare.
+   */
+  bool getValue(const QString &str, quint64 &value) const;
+
 private:
   QList<SymbolEntry> entries;
+
+  // Positions of named entries in entries sorted by value.
+  QVector<int> index;
+  bool indexed;
 };
 
 #endif // BMOD_SYMBOL_TABLE_H
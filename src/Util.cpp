@@ -1,12 +1,41 @@
 #include <QDir>
-#include <QWidget>
 #include <QFileInfo>
-#include <QApplication>
-#include <QDesktopWidget>
-#include <QTreeWidgetItem>
+
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "Util.h"
 
+namespace {
+  // Upper-case hex digits of each byte as UTF-16.
+  struct HexTable {
+    HexTable() {
+      static const char digits[] = "0123456789ABCDEF";
+      for (int i = 0; i < 256; i++) {
+        chars[i][0] = digits[i >> 4];
+        chars[i][1] = digits[i & 0xF];
+      }
+    }
+
+    ushort chars[256][2];
+  };
+
+  const HexTable &hexTable() {
+    static const HexTable table;
+    return table;
+  }
+
+  int hexValue(ushort c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+  }
+}
+
 QString Util::formatTypeString(FormatType type) {
   switch (type) {
   default:
@@ -138,11 +167,6 @@ QString Util::sectionTypeString(SectionType type) {
   }
 }
 
-void Util::centerWidget(QWidget *widget) {
-  widget->move(QApplication::desktop()->screen()->rect().center()
-               - widget->rect().center());
-}
-
 QString Util::formatSize(qint64 bytes, int digits) {
   constexpr double KB = 1024, MB = 1024 * KB, GB = 1024 * MB, TB = 1024 * GB;
   QString unit{"B"};
@@ -176,15 +200,103 @@ QString Util::padString(const QString &str, int size, bool before, char pad) {
 }
 
 QString Util::dataToAscii(const QByteArray &data, int offset, int size) {
-  QString res;
-  int len = data.size();
-  for (int i = offset; i - offset < size && i < len; i++) {
-    int ic = data[i];
-    res += (ic >= 32 && ic <= 126 ? (char) ic : '.');
+  int end = qMin(offset + size, data.size());
+  if (offset < 0 || offset >= end) {
+    return QString();
   }
+
+  QString res(end - offset, Qt::Uninitialized);
+  formatAscii(data.constData() + offset, end - offset, res.data());
   return res;
 }
 
+QString Util::dataToHex(const QByteArray &data, int offset, int size,
+                        bool spaced) {
+  int end = qMin(offset + size, data.size());
+  if (offset < 0 || offset >= end) {
+    return QString();
+  }
+
+  int len = end - offset;
+  const char *ptr = data.constData() + offset;
+  if (!spaced) {
+    QString res(2 * len, Qt::Uninitialized);
+    formatHex(ptr, len, res.data());
+    return res;
+  }
+  QString res(3 * len - 1, Qt::Uninitialized);
+  formatHexSpaced(ptr, len, res.data());
+  return res;
+}
+
+void Util::formatHex(const char *data, int size, QChar *out) {
+  ushort *dst = reinterpret_cast<ushort*>(out);
+  int i{0};
+#ifdef __SSE2__
+  // Nibbles to digits 16 bytes at a time, widened to UTF-16.
+  const __m128i mask = _mm_set1_epi8(0x0F), nine = _mm_set1_epi8(9),
+    zero = _mm_set1_epi8('0'), letter = _mm_set1_epi8('A' - '0' - 10),
+    none = _mm_setzero_si128();
+  for (; i + 16 <= size; i += 16, dst += 32) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)),
+      hi = _mm_and_si128(_mm_srli_epi16(v, 4), mask),
+      lo = _mm_and_si128(v, mask);
+    hi = _mm_add_epi8(_mm_add_epi8(hi, zero),
+                      _mm_and_si128(_mm_cmpgt_epi8(hi, nine), letter));
+    lo = _mm_add_epi8(_mm_add_epi8(lo, zero),
+                      _mm_and_si128(_mm_cmpgt_epi8(lo, nine), letter));
+
+    __m128i first = _mm_unpacklo_epi8(hi, lo),
+      second = _mm_unpackhi_epi8(hi, lo);
+    __m128i *d = reinterpret_cast<__m128i*>(dst);
+    _mm_storeu_si128(d, _mm_unpacklo_epi8(first, none));
+    _mm_storeu_si128(d + 1, _mm_unpackhi_epi8(first, none));
+    _mm_storeu_si128(d + 2, _mm_unpacklo_epi8(second, none));
+    _mm_storeu_si128(d + 3, _mm_unpackhi_epi8(second, none));
+  }
+#endif
+
+  const auto &table = hexTable().chars;
+  for (; i < size; i++, dst += 2) {
+    memcpy(dst, table[(uchar) data[i]], sizeof(table[0]));
+  }
+}
+
+void Util::formatHexSpaced(const char *data, int size, QChar *out) {
+  if (size <= 0) return;
+  ushort *dst = reinterpret_cast<ushort*>(out);
+  const auto &table = hexTable().chars;
+  for (int i = 0; i < size - 1; i++, dst += 3) {
+    memcpy(dst, table[(uchar) data[i]], sizeof(table[0]));
+    dst[2] = ' ';
+  }
+  memcpy(dst, table[(uchar) data[size - 1]], sizeof(table[0]));
+}
+
+void Util::formatAscii(const char *data, int size, QChar *out) {
+  ushort *dst = reinterpret_cast<ushort*>(out);
+  int i{0};
+#ifdef __SSE2__
+  // Bytes from 32 to 126 are kept. The comparisons are signed, so bytes
+  // from 128 are negative and fail the first.
+  const __m128i low = _mm_set1_epi8(31), high = _mm_set1_epi8(127),
+    dot = _mm_set1_epi8('.'), none = _mm_setzero_si128();
+  for (; i + 16 <= size; i += 16, dst += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)),
+      keep = _mm_and_si128(_mm_cmpgt_epi8(v, low), _mm_cmplt_epi8(v, high)),
+      res = _mm_or_si128(_mm_and_si128(keep, v), _mm_andnot_si128(keep, dot));
+    __m128i *d = reinterpret_cast<__m128i*>(dst);
+    _mm_storeu_si128(d, _mm_unpacklo_epi8(res, none));
+    _mm_storeu_si128(d + 1, _mm_unpackhi_epi8(res, none));
+  }
+#endif
+
+  for (; i < size; i++) {
+    uchar c = data[i];
+    *dst++ = (c >= 32 && c <= 126 ? c : '.');
+  }
+}
+
 QString Util::hexToAscii(const QString &str, int offset, int blocks,
                          bool unicode) {
   QString res;
@@ -214,12 +326,20 @@ QString Util::hexToString(const QString &str) {
 }
 
 QByteArray Util::hexToData(const QString &str) {
-  QByteArray data;
+  // A single digit at the end is a byte of its own.
   int size = str.size();
-  bool ok;
+  QByteArray data((size + 1) / 2, Qt::Uninitialized);
+  const QChar *src = str.constData();
+  char *dst = data.data();
   for (int i = 0; i < size; i += 2) {
-    data += str.mid(i, 2).toInt(&ok, 16);
-    if (!ok) return QByteArray();
+    int hi = hexValue(src[i].unicode()),
+      lo = (i + 1 < size ? hexValue(src[i + 1].unicode()) : 0);
+    if (hi < 0 || lo < 0) return QByteArray();
+    if (i + 1 == size) {
+      *dst = hi;
+      break;
+    }
+    *dst++ = (hi << 4) | lo;
   }
   return data;
 }
@@ -238,43 +358,27 @@ QString Util::resolveAppBinary(const QString &path) {
   return QString();
 }
 
-void Util::setTreeItemMarked(QTreeWidgetItem *item, int column) {
-  auto font = item->font(column);
-  font.setBold(true);
-  item->setFont(column, font);
-  item->setForeground(column, Qt::red);
-}
-
 QString Util::addrDataString(quint64 addr, QByteArray data) {
   // Pad data to a multiple of 16.
-  quint64 rest = data.size() % 16;
+  int rest = data.size() % 16;
   if (rest != 0) {
-    int amount = 16 - rest;
-    for (int i = 0; i < amount; i++) {
-      data += (char) 0;
-    }
+    data += QByteArray(16 - rest, 0);
   }
 
-  QString output = QString::number(addr, 16).toUpper() + ": ";
-  QString ascii;
-  for (int i = 0; i < data.size(); i++) {
-    char c = data[i];
-    int ic = c;
-    unsigned char uc = c;
-    QString hc = QString::number(uc, 16).toUpper();
-    if (hc.size() == 1) {
-      hc = "0" + hc;
-    }
-    output += hc + " ";
-    ascii += (ic >= 33 && ic <= 126 ? c : '.');
-    if ((i + 1) % 16 == 0 || i == data.size() - 1) {
-      output += "  " + ascii;
-      ascii.clear();
-      if (i != data.size() - 1) {
-        addr += 16;
-        output += "\n" + QString::number(addr, 16).toUpper() + ": ";
-      }
+  // Each line is the address, hex of 16 bytes and the ASCII of them.
+  QString output, line(16 * 3 + 2 + 16, ' ');
+  for (int i = 0; i < data.size(); i += 16, addr += 16) {
+    const char *ptr = data.constData() + i;
+    formatHexSpaced(ptr, 16, line.data());
+
+    // Unlike dataToAscii(), spaces are shown as dots.
+    QChar *ascii = line.data() + 16 * 3 + 2;
+    formatAscii(ptr, 16, ascii);
+    for (int j = 0; j < 16; j++) {
+      if (ascii[j] == ' ') ascii[j] = '.';
     }
+    if (i > 0) output += '\n';
+    output += QString::number(addr, 16).toUpper() + ": " + line;
   }
   return output;
 }
@@ -9,9 +9,6 @@
 #include "FileType.h"
 #include "formats/FormatType.h"
 
-class QWidget;
-class QTreeWidgetItem;
-
 class Util {
 public:
   static QString formatTypeString(FormatType type);
@@ -19,7 +16,6 @@ public:
   static QString fileTypeString(FileType type);
   static QString sectionTypeString(SectionType type);
 
-  static void centerWidget(QWidget *widget);
   static QString formatSize(qint64 bytes, int digits = 1);
 
   // char(48) = '0'
@@ -27,15 +23,33 @@ public:
                            char pad = 48);
 
   static QString dataToAscii(const QByteArray &data, int offset, int size);
+
+  /**
+   * Upper-case hex bytes separated by spaces, like "0F 1F 00", or
+   * without spaces if not spaced.
+   */
+  static QString dataToHex(const QByteArray &data, int offset, int size,
+                           bool spaced = true);
+
+  /**
+   * Formatting kernels writing size bytes of data into a buffer that
+   * is large enough: 2 chars per byte of hex, 3 * size - 1 chars of hex
+   * separated by spaces, and 1 char per byte of printable ASCII with
+   * '.' for other bytes.
+   */
+  static void formatHex(const char *data, int size, QChar *out);
+  static void formatHexSpaced(const char *data, int size, QChar *out);
+  static void formatAscii(const char *data, int size, QChar *out);
+
   static QString hexToAscii(const QString &data, int offset, int blocks,
                             bool unicode = false);
   static QString hexToString(const QString &str);
+
+  // Hex digits to bytes, or empty if any is invalid.
   static QByteArray hexToData(const QString &str);
 
   static QString resolveAppBinary(const QString &path);
 
-  static void setTreeItemMarked(QTreeWidgetItem *item, int column);
-
   /**
    * Generate string of format:
    *
@@ -6,8 +6,62 @@
 
 class Asm {
 public:
+  Asm() : batchSize{0}, reported{0} { }
   virtual ~Asm() { }
   virtual bool disassemble(SectionPtr sec, Disassembly &result) =0;
+
+  /**
+   * Decode one instruction at a time: begin() starts at the beginning
+   * of the section and each step() appends the next instruction to the
+   * result. step() returns false at the end of the section. If the
+   * bytes run out in the middle of an instruction then they are
+   * appended as data.
+   */
+  virtual void begin(SectionPtr sec) =0;
+  virtual bool step(Disassembly &result) =0;
+
+  // Append size bytes at offset that aren't an instruction as data.
+  virtual void addData(const char *bytes, int size, quint32 offset,
+                       Disassembly &result) =0;
+
+  // Append the text of instruction index of the result to out.
+  virtual void render(const Disassembly &result, int index,
+                      QString &out) const =0;
+
+  void setBatchFunc(Disassembler::BatchFunc func, int size) {
+    batchFunc = func;
+    batchSize = size;
+  }
+
+protected:
+  /**
+   * Hands the decoded lines over to the batch function, if any, when
+   * enough have been collected or if forced. The lines are removed
+   * from the result. Returns false if the batch function cancelled.
+   */
+  bool reportBatch(Disassembly &result, qint64 pos, bool force = false) {
+    if (!batchFunc) return true;
+
+    // Report the first lines early so they can be shown right away.
+    int lines = result.size();
+    if (lines == 0 || (!force && lines < (reported == 0 ? 256 : batchSize))) {
+      return true;
+    }
+
+    reported += lines;
+    bool cont = batchFunc(result, pos);
+    result = Disassembly();
+    return cont;
+  }
+
+  // Number of lines handed over to the batch function.
+  qint64 getReported() const { return reported; }
+  void resetReported() { reported = 0; }
+
+private:
+  Disassembler::BatchFunc batchFunc;
+  int batchSize;
+  qint64 reported;
 };
 
 #endif // BMOD_ASM_H
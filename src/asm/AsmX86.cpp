@@ -9,7 +9,6 @@
  */
 
 #include <QDebug>
-#include <QBuffer>
 
 #include <cmath>
 
@@ -19,8 +18,74 @@
 #include "../Section.h"
 
 namespace {
-  QString Instruction::toString(BinaryObjectPtr obj) const {
-    QString str(mnemonic);
+  // Bits of Disassembly::Operands::flags.
+  enum OperandFlag : quint16 {
+    SrcRegSetFlag = 0x1,
+    DstRegSetFlag = 0x2,
+    SipSrcFlag = 0x4,
+    SipDstFlag = 0x8,
+    DispSrcFlag = 0x10,
+    DispDstFlag = 0x20,
+    ImmSrcFlag = 0x40,
+    ImmDstFlag = 0x80,
+    CallFlag = 0x100
+  };
+
+  Instruction::Instruction(const Disassembly::Operands &ops)
+    : Instruction()
+  {
+    dataType = (DataType) ops.dataType;
+    srcReg = ops.srcReg;
+    dstReg = ops.dstReg;
+    srcRegType = (RegType) ops.srcRegType;
+    dstRegType = (RegType) ops.dstRegType;
+    scale = ops.scale;
+    index = ops.index;
+    base = ops.base;
+    disp = ops.disp;
+    imm = ops.imm;
+    dispBytes = ops.dispBytes;
+    immBytes = ops.immBytes;
+    srcRegSet = (ops.flags & SrcRegSetFlag);
+    dstRegSet = (ops.flags & DstRegSetFlag);
+    sipSrc = (ops.flags & SipSrcFlag);
+    sipDst = (ops.flags & SipDstFlag);
+    dispSrc = (ops.flags & DispSrcFlag);
+    dispDst = (ops.flags & DispDstFlag);
+    immSrc = (ops.flags & ImmSrcFlag);
+    immDst = (ops.flags & ImmDstFlag);
+    call = (ops.flags & CallFlag);
+  }
+
+  Disassembly::Operands Instruction::getOperands() const {
+    Disassembly::Operands ops;
+
+    // The offset is only needed to resolve the displacement and
+    // immediate, so resolve them now.
+    ops.disp = disp + offset;
+    ops.imm = imm + offset;
+    ops.srcReg = srcReg;
+    ops.dstReg = dstReg;
+    ops.scale = scale;
+    ops.index = index;
+    ops.base = base;
+    ops.srcRegType = (quint8) srcRegType;
+    ops.dstRegType = (quint8) dstRegType;
+    ops.dataType = (quint8) dataType;
+    ops.dispBytes = dispBytes;
+    ops.immBytes = immBytes;
+    ops.flags = (srcRegSet ? SrcRegSetFlag : 0) |
+      (dstRegSet ? DstRegSetFlag : 0) | (sipSrc ? SipSrcFlag : 0) |
+      (sipDst ? SipDstFlag : 0) | (dispSrc ? DispSrcFlag : 0) |
+      (dispDst ? DispDstFlag : 0) | (immSrc ? ImmSrcFlag : 0) |
+      (immDst ? ImmDstFlag : 0) | (call ? CallFlag : 0);
+    return ops;
+  }
+
+  void Instruction::toString(BinaryObjectPtr obj, QString &str) const {
+    if (mnemonic) {
+      str += mnemonic;
+    }
     switch (dataType) {
     case DataType::None:
       // Nothing.
@@ -53,7 +118,7 @@ namespace {
       if (symTable.getString(addr, name) || dynsymTable.getString(addr, name)) {
         str += " (" + name + ")";
       }
-      return str;
+      return;
     }
 
     bool comma{true};
@@ -130,7 +195,6 @@ namespace {
       if (!str.endsWith(" ")) str += " ";
       str += getImmString();
     }
-    return str;
   }
 
   void Instruction::reverse() {
@@ -216,826 +280,661 @@ namespace {
   QString Instruction::formatHex(quint64 num, int len) const {
     return "0x" + Util::padString(QString::number(num, 16).toUpper(), len);
   }
+
+  // Mod-R/M reg field opcode extensions.
+  const char *group1[8] = // 0x80, 0x81, 0x83
+    {"add", "or", "adc", "sbb", "and", "sub", "xor", "cmp"};
+  const char *group2[8] = // 0xC1
+    {"rol", "ror", "rcl", "rcr", "shl", "shr", "sal", "sar"};
+  const char *group5[7] = // 0xFF
+    {"inc", "dec", "call *", "callf", "jmp *", "jmpf", "push"};
+
+  // Special NOP sequences in the order handleNops() matches them.
+  const char *nops[] = {
+    "nopw %cs:0L(%eax,%eax,1)",
+    "nopw 0L(%eax,%eax,1)",
+    "nopl 0L(%eax,%eax,1)",
+    "nopl 0L(%eax)",
+    "nopw 0x0(%eax,%eax,1)",
+    "nopl 0x0(%eax,%eax,1)",
+    "nopl 0x0(%eax)",
+    "xchg %ax,%ax"
+  };
 }
 
-AsmX86::AsmX86(BinaryObjectPtr obj) : obj{obj}, reader{nullptr} { }
+const int AsmX86::windowSize;
+
+AsmX86::AsmX86(BinaryObjectPtr obj)
+  : obj{obj}, base{0}, size{0}, reader{nullptr}, funcAddr{0}, instPos{0},
+  _64{false}
+{ }
+
+// Primary one-byte opcode map.
+const AsmX86::OpEntry AsmX86::primaryMap[256] = {
+  /* 00 */ {},
+  /* 01 */ {&AsmX86::decodeModRM, "add", NeedsNext | Reverse}, // ADD (r/m16/32  r16/32)
+  /* 02 */ {},
+  /* 03 */ {&AsmX86::decodeModRM, "add", NeedsNext}, // ADD (r16/32  r/m16/32)
+  /* 04 */ {},
+  /* 05 */ {&AsmX86::decodeAccImm, "add", 0}, // ADD (eAX  imm16/32)
+  /* 06-08 */ {}, {}, {},
+  /* 09 */ {&AsmX86::decodeModRM, "or", Reverse}, // OR (r/m16/32  r16/32)
+  /* 0A-0C */ {}, {}, {},
+  /* 0D */ {&AsmX86::decodeAccImm, "or", 0}, // OR (eAX  imm16/32)
+  /* 0E */ {},
+  /* 0F */ {}, // Two-byte escape (secondaryMap)
+  /* 10-17 */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* 18-1F */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* 20-22 */ {}, {}, {},
+  /* 23 */ {&AsmX86::decodeModRM, "and", NeedsNext}, // AND (r16/32  r/m16/32)
+  /* 24 */ {&AsmX86::decodeAccImm, "and", Byte}, // AND (AL  imm8)
+  /* 25 */ {&AsmX86::decodeAccImm, "and", 0}, // AND (eAX  imm16/32)
+  /* 26-28 */ {}, {}, {},
+  /* 29 */ {&AsmX86::decodeModRM, "sub", NeedsNext | Reverse}, // SUB (r/m16/32  r16/32)
+  /* 2A-2C */ {}, {}, {},
+  /* 2D */ {&AsmX86::decodeAccImm, "sub", 0}, // SUB (eAX  imm16/32)
+  /* 2E-30 */ {}, {}, {},
+  /* 31 */ {&AsmX86::decodeModRM, "xor", NeedsNext}, // XOR (r/m16/32/64  r16/32/64)
+  /* 32-39 */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* 3A */ {},
+  /* 3B */ {&AsmX86::decodeModRM, "cmp", NeedsNext}, // CMP (r16/32  r/m16/32)
+  /* 3C */ {},
+  /* 3D */ {&AsmX86::decodeAccImm, "cmp", 0}, // CMP (eAX  imm16/32)
+  /* 3E-45 */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* 46-4D */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* 4E-4F */ {}, {},
+  /* 50 */ {&AsmX86::decodeStackReg, "push", 0}, // PUSH (r16/32)
+  /* 51 */ {&AsmX86::decodeStackReg, "push", 0}, // PUSH (r16/32)
+  /* 52 */ {&AsmX86::decodeStackReg, "push", 0}, // PUSH (r16/32)
+  /* 53 */ {&AsmX86::decodeStackReg, "push", 0}, // PUSH (r16/32)
+  /* 54 */ {&AsmX86::decodeStackReg, "push", 0}, // PUSH (r16/32)
+  /* 55 */ {&AsmX86::decodeStackReg, "push", 0}, // PUSH (r16/32)
+  /* 56 */ {&AsmX86::decodeStackReg, "push", 0}, // PUSH (r16/32)
+  /* 57 */ {&AsmX86::decodeStackReg, "push", 0}, // PUSH (r16/32)
+  /* 58 */ {&AsmX86::decodeStackReg, "pop", 0}, // POP (r16/32)
+  /* 59 */ {&AsmX86::decodeStackReg, "pop", 0}, // POP (r16/32)
+  /* 5A */ {&AsmX86::decodeStackReg, "pop", 0}, // POP (r16/32)
+  /* 5B */ {&AsmX86::decodeStackReg, "pop", 0}, // POP (r16/32)
+  /* 5C */ {&AsmX86::decodeStackReg, "pop", 0}, // POP (r16/32)
+  /* 5D */ {&AsmX86::decodeStackReg, "pop", 0}, // POP (r16/32)
+  /* 5E */ {&AsmX86::decodeStackReg, "pop", 0}, // POP (r16/32)
+  /* 5F */ {&AsmX86::decodeStackReg, "pop", 0}, // POP (r16/32)
+  /* 60-62 */ {}, {}, {},
+  /* 63 */ {&AsmX86::decodeModRM, "movsl", NeedsNext}, // MOVSXD (r32/64  r/m32)
+  /* 64-69 */ {}, {}, {}, {}, {}, {},
+  /* 6A */ {&AsmX86::decodePushImm, "push", NeedsNext}, // PUSH (imm8)
+  /* 6B */ {},
+  /* 6C */ {&AsmX86::decodeIns, "ins", NeedsNext}, // INS (m8  DX)
+  /* 6D-74 */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* 75 */ {&AsmX86::decodeJneRel8, "jne", NeedsNext}, // JNZ/JNE (rel8)
+  /* 76-7D */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* 7E-7F */ {}, {},
+  /* 80 */ {&AsmX86::decodeGroup1, nullptr, NeedsNext | Byte | Imm8}, // Group 1 (r/m8  imm8)
+  /* 81 */ {&AsmX86::decodeGroup1, nullptr, NeedsNext}, // Group 1 (r/m16/32  imm16/32)
+  /* 82 */ {},
+  /* 83 */ {&AsmX86::decodeGroup1, nullptr, NeedsNext | Imm8}, // Group 1 (r/m16/32  imm8)
+  /* 84 */ {},
+  /* 85 */ {&AsmX86::decodeModRM, "test", NeedsNext | Reverse}, // TEST (r/m16/32  r16/32)
+  /* 86-87 */ {}, {},
+  /* 88 */ {&AsmX86::decodeModRM, "mov", NeedsNext | Reverse | Byte}, // MOV (r/m8  r8)
+  /* 89 */ {&AsmX86::decodeModRM, "mov", NeedsNext | Reverse}, // MOV (r/m16/32  r16/32)
+  /* 8A */ {&AsmX86::decodeModRM, "mov", NeedsNext | Byte}, // MOV (r8  r/m8)
+  /* 8B */ {&AsmX86::decodeModRM, "mov", NeedsNext}, // MOV (r16/32  r/m16/32)
+  /* 8C */ {},
+  /* 8D */ {&AsmX86::decodeModRM, "lea", NeedsNext}, // LEA (r16/32  m)
+  /* 8E-8F */ {}, {},
+  /* 90 */ {&AsmX86::decodeFixed, "nop", 0}, // NOP
+  /* 91-98 */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* 99-A0 */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* A1-A7 */ {}, {}, {}, {}, {}, {}, {},
+  /* A8 */ {&AsmX86::decodeTestAlImm, "testb", NeedsNext}, // TEST (AL  imm8)
+  /* A9-AF */ {}, {}, {}, {}, {}, {}, {},
+  /* B0 */ {&AsmX86::decodeMovRegImm, "mov", Byte}, // MOV (r8  imm8)
+  /* B1 */ {&AsmX86::decodeMovRegImm, "mov", Byte}, // MOV (r8  imm8)
+  /* B2 */ {&AsmX86::decodeMovRegImm, "mov", Byte}, // MOV (r8  imm8)
+  /* B3 */ {&AsmX86::decodeMovRegImm, "mov", Byte}, // MOV (r8  imm8)
+  /* B4 */ {&AsmX86::decodeMovRegImm, "mov", Byte}, // MOV (r8  imm8)
+  /* B5 */ {&AsmX86::decodeMovRegImm, "mov", Byte}, // MOV (r8  imm8)
+  /* B6 */ {&AsmX86::decodeMovRegImm, "mov", Byte}, // MOV (r8  imm8)
+  /* B7 */ {&AsmX86::decodeMovRegImm, "mov", Byte}, // MOV (r8  imm8)
+  /* B8 */ {&AsmX86::decodeMovRegImm, "mov", 0}, // MOV (r16/32  imm16/32)
+  /* B9 */ {&AsmX86::decodeMovRegImm, "mov", 0}, // MOV (r16/32  imm16/32)
+  /* BA */ {&AsmX86::decodeMovRegImm, "mov", 0}, // MOV (r16/32  imm16/32)
+  /* BB */ {&AsmX86::decodeMovRegImm, "mov", 0}, // MOV (r16/32  imm16/32)
+  /* BC */ {&AsmX86::decodeMovRegImm, "mov", 0}, // MOV (r16/32  imm16/32)
+  /* BD */ {&AsmX86::decodeMovRegImm, "mov", 0}, // MOV (r16/32  imm16/32)
+  /* BE */ {&AsmX86::decodeMovRegImm, "mov", 0}, // MOV (r16/32  imm16/32)
+  /* BF */ {&AsmX86::decodeMovRegImm, "mov", 0}, // MOV (r16/32  imm16/32)
+  /* C0 */ {},
+  /* C1 */ {&AsmX86::decodeGroup2, nullptr, 0}, // Group 2 (r/m16/32  imm8)
+  /* C2 */ {},
+  /* C3 */ {&AsmX86::decodeFixed, "ret", 0}, // RETN
+  /* C4-C5 */ {}, {},
+  /* C6 */ {&AsmX86::decodeMovRmImm, "mov", NeedsNext | Byte}, // MOV (r/m8  imm8)
+  /* C7 */ {&AsmX86::decodeMovRmImm, "mov", NeedsNext}, // MOV (r/m16/32  imm16/32)
+  /* C8-CF */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* D0-D7 */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* D8-DF */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* E0-E7 */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* E8 */ {&AsmX86::decodeCall, "call", 0}, // CALL (rel16/32)
+  /* E9 */ {&AsmX86::decodeJmpRel, "jmp", 0}, // JMP (rel16/32)
+  /* EA */ {},
+  /* EB */ {&AsmX86::decodeJmpRel, "jmp", NeedsNext | Imm8}, // JMP (rel8)
+  /* EC-F3 */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* F4 */ {&AsmX86::decodeFixed, "hlt", 0}, // HLT
+  /* F5-FC */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* FD-FE */ {}, {},
+  /* FF */ {&AsmX86::decodeGroup5, nullptr, NeedsNext}, // Group 5 (INC, DEC, CALL, JMP, PUSH)
+};
+
+// Two-byte opcode map (0x0F xx).
+const AsmX86::OpEntry AsmX86::secondaryMap[256] = {
+  /* 00-07 */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* 08-0F */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* 10-17 */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* 18-1E */ {}, {}, {}, {}, {}, {}, {},
+  /* 1F */ {&AsmX86::decodeModRM, "nop", NeedsNext | SrcOnly}, // NOP (r/m16/32)
+  /* 20-27 */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* 28-2F */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* 30-37 */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* 38-3F */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* 40-47 */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* 48-4F */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* 50-57 */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* 58-5F */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* 60-67 */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* 68-6F */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* 70-77 */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* 78-7F */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* 80-82 */ {}, {}, {},
+  /* 83 */ {&AsmX86::decodeJmpRel, "jae", 0}, // JNB/JAE/JNC (rel16/32)
+  /* 84 */ {&AsmX86::decodeJmpRel, "je", 0}, // JZ/JE (rel16/32)
+  /* 85 */ {&AsmX86::decodeJmpRel, "jne", 0}, // JNZ/JNE (rel16/32)
+  /* 86 */ {},
+  /* 87 */ {&AsmX86::decodeJmpRel, "ja", 0}, // JA/JNBE (rel16/32)
+  /* 88-8C */ {}, {}, {}, {}, {},
+  /* 8D */ {&AsmX86::decodeJmpRel, "jge", 0}, // JNL/JGE (rel16/32)
+  /* 8E */ {&AsmX86::decodeJmpRel, "jle", 0}, // JLE/JNG (rel16/32)
+  /* 8F */ {&AsmX86::decodeJmpRel, "jg", 0}, // JNLE/JG (rel16/32)
+  /* 90-93 */ {}, {}, {}, {},
+  /* 94 */ {&AsmX86::decodeSetcc, "sete", NeedsNext}, // SETZ/SETE (r/m8)
+  /* 95 */ {&AsmX86::decodeSetcc, "setne", NeedsNext}, // SETNZ/SETNE (r/m8)
+  /* 96-9D */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* 9E-A5 */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* A6-AD */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* AE-B5 */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* B6 */ {&AsmX86::decodeModRM, "movzb", 0}, // MOVZX (r16/32  r/m8)
+  /* B7-BD */ {}, {}, {}, {}, {}, {}, {},
+  /* BE */ {&AsmX86::decodeModRM, "movsb", NeedsNext}, // MOVSX (r16/32  r/m8)
+  /* BF-C6 */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* C7-CE */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* CF-D6 */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* D7-DE */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* DF-E6 */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* E7-EE */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* EF-F6 */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* F7-FE */ {}, {}, {}, {}, {}, {}, {}, {},
+  /* FF */ {}
+};
 
 bool AsmX86::disassemble(SectionPtr sec, Disassembly &result) {
-  QBuffer buf;
-  buf.setData(sec->getData());
-  buf.open(QIODevice::ReadOnly);
-  reader.reset(new Reader(buf));
-
-  // Address of main()
-  quint64 funcAddr = sec->getAddress();
-
-  bool ok{true}, peek{false};
-  unsigned char ch, nch;
-  qint64 pos{0};
-  Instruction inst;
-  const bool _64 = (obj->getSystemBits() == 64);
-  while (!reader->atEnd()) {
-    // Handle special NOP sequences.
-    if (handleNops(result)) {
-      continue;
-    }
-
-    pos = reader->pos();
-    ch = reader->getUChar(&ok);
-    if (!ok) return false;
-
-    nch = reader->peekUChar(&peek);
-
-    // Instruction to fill.
-    inst = Instruction();
-    inst.dataType = DataType::Doubleword;
-    inst.srcRegType = inst.dstRegType = (_64 ? RegType::R64 : RegType::R32);
-
-    // REX mode (64-bit ONLY!).
-    if (_64 && ch >= 0x40 && ch <= 0x4F) {
-      // W=1 => 64-bit
-      // R=1 => Extension to Mod-R/M: reg
-      // X=1 => Extension to SIB index
-      // B=1 => Extension to Mod-R/M: R/M oR SIB base
-      splitRex(ch, inst.rexW, inst.rexR, inst.rexX, inst.rexB);
-      if (inst.rexW) {
-        inst.dataType = DataType::Quadword;
-      }
-
-      // Setup for next.
-      ch = reader->getUChar(&ok);
-      if (!ok) return false;
-
-      nch = reader->peekUChar(&peek);
-    }
-
-    // ADD (r/m16/32  r16/32) (reverse of 0x03)
-    if (ch == 0x01 && peek) {
-      inst.mnemonic = "add";
-      processModRegRM(inst);
-      inst.reverse();
-      addResult(inst, pos, result);
-    }
-
-    // ADD (r16/32  r/m16/32)
-    else if (ch == 0x03 && peek) {
-      inst.mnemonic = "add";
-      processModRegRM(inst);
-      addResult(inst, pos, result);
-    }
-
-    // ADD (eAX  imm16/32)
-    else if (ch == 0x05) {
-      inst.mnemonic = "add";
-      inst.imm = reader->getUInt32();
-      inst.immBytes = 4;
-      inst.immSrc = true;
-
-      // Dst is always %eax.
-      inst.dstReg = 0;
-      inst.dstRegSet = true;
-
-      addResult(inst, pos, result);
-    }
-
-    // PUSH (imm8)
-    else if (ch == 0x6A && peek) {
-      inst.mnemonic = "push";
-      if (_64) inst.dataType = DataType::Quadword;
-      inst.immDst = true;
-      inst.dstRegSet = false;
-      processImm8(inst);
-      addResult(inst, pos, result);
-    }
-
-    // OR (r/m16/32  r16/32)
-    else if (ch == 0x09) {
-      inst.mnemonic = "or";
-      processModRegRM(inst);
-      inst.reverse();
-      addResult(inst, pos, result);
-    }
-
-    // OR (eAX  imm16/32)
-    else if (ch == 0x0D) {
-      inst.mnemonic = "or";
-      inst.imm = reader->getUInt32();
-      inst.immBytes = 4;
-      inst.immSrc = true;
-
-      // Dst is always %eax.
-      inst.dstReg = 0;
-      inst.dstRegSet = true;
-
-      addResult(inst, pos, result);
-    }
-
-    // AND (r16/32  r/m16/32)
-    else if (ch == 0x23 && peek) {
-      inst.mnemonic = "and";
-      processModRegRM(inst);
-      addResult(inst, pos, result);
+  begin(sec);
+  resetReported();
+  while (!atEnd()) {
+    if (!reportBatch(result, getPos())) {
+      return false;
     }
-
-    // AND (AL  imm8)
-    else if (ch == 0x24) {
-      inst.mnemonic = "and";
-      inst.dataType = DataType::Byte;
-      inst.srcRegType = inst.dstRegType = RegType::R8;
-      inst.imm = reader->getUChar();
-      inst.immBytes = 1;
-      inst.immSrc = true;
-
-      // Dst is always %al.
-      inst.dstReg = 0;
-      inst.dstRegSet = true;
-
-      addResult(inst, pos, result);
-    }
-
-    // AND (eAX  imm16/32)
-    else if (ch == 0x25) {
-      inst.mnemonic = "and";
-      inst.imm = reader->getUInt32();
-      inst.immBytes = 4;
-      inst.immSrc = true;
-
-      // Dst is always %eax.
-      inst.dstReg = 0;
-      inst.dstRegSet = true;
-
-      addResult(inst, pos, result);
-    }
-
-    // SUB (r/m16/32  r16/32)
-    else if (ch == 0x29 && peek) {
-      inst.mnemonic = "sub";
-      processModRegRM(inst);
-      inst.reverse();
-      addResult(inst, pos, result);
-    }
-
-    // SUB (eAX  imm16/32)
-    else if (ch == 0x2D) {
-      inst.mnemonic = "sub";
-      inst.imm = reader->getUInt32();
-      inst.immBytes = 4;
-      inst.immSrc = true;
-
-      // Dst is always %eax.
-      inst.dstReg = 0;
-      inst.dstRegSet = true;
-
-      addResult(inst, pos, result);
-    }
-
-    // XOR (r/m16/32/64  r16/32/64)
-    else if (ch == 0x31 && peek) {
-      inst.mnemonic = "xor";
-      processModRegRM(inst);
-      addResult(inst, pos, result);
-    }
-
-    // CMP (r16/32 r/m16/32)
-    else if (ch == 0x3B && peek) {
-      inst.mnemonic = "cmp";
-      processModRegRM(inst);
-      addResult(inst, pos, result);
-    }
-
-    // CMP (eAX  imm16/32)
-    else if (ch == 0x3D) {
-      inst.mnemonic = "cmp";
-      inst.imm = reader->getUInt32();
-      inst.immBytes = 4;
-      inst.immSrc = true;
-
-      // Dst is always %eax.
-      inst.dstReg = 0;
-      inst.dstRegSet = true;
-
-      addResult(inst, pos, result);
-    }
-
-    // PUSH (r16/32)
-    else if (ch >= 0x50 && ch <= 0x57) {
-      inst.mnemonic = "push";
-      if (_64) inst.dataType = DataType::Quadword;
-      inst.srcReg = getR(ch);
-      inst.srcRegSet = true;
-      addResult(inst, pos, result);
-    }
-
-    // POP (r16/32)
-    else if (ch >= 0x58 && ch <= 0x5F) {
-      inst.mnemonic = "pop";
-      if (_64) inst.dataType = DataType::Quadword;
-      inst.srcReg = getR(ch);
-      inst.srcRegSet = true;
-      addResult(inst, pos, result);
-    }
-
-    // MOVSXD (r32/64  r/m32)
-    // Move with Sign-Extension
-    else if (ch == 0x63 && peek) {
-      inst.mnemonic = "movsl";
-      processModRegRM(inst);
-      addResult(inst, pos, result);
-    }
-
-    // INS (m8  DX) or INSB (m8  DX)
-    else if (ch == 0x6C && peek) {
-      inst.mnemonic = "ins";
-      inst.dataType = DataType::Byte;
-      processModRegRM(inst);
-
-      // Src is always %dx/dl
-      inst.srcReg = 2;
-      inst.srcRegType = RegType::R8;
-      inst.srcRegSet = true;
-
-      addResult(inst, pos, result);
-    }
-
-    // JNZ (rel8) or JNE (rel8)
-    // Short jump
-    else if (ch == 0x75 && peek) {
-      inst.mnemonic = "jne";
-      inst.disp = pos - (255 - (int) reader->getUChar()) + 1;
-      inst.dispBytes = 1;
-      inst.dispDst = true;
-      inst.offset = funcAddr;
-      inst.dataType = DataType::None;
-      addResult(inst, pos, result);
+    if (!step(result)) {
+      return false;
     }
+  }
 
-    // ADD, OR, ADC, SBB, AND, SUB, XOR, CMP
-    // (r/m8  imm8)
-    else if (ch == 0x80 && peek) {
-      inst.dataType = DataType::Byte;
-      inst.srcRegType = inst.dstRegType = RegType::R8;
-      processModRegRM(inst, true);
-
-      inst.immSrc = true;
-      processImm8(inst);
-
-      // Don't display the 'dst' after the 'src'.
-      inst.dstRegSet = false;
-
-      if (inst.dstReg == 0) {
-        inst.mnemonic = "add";
-      }
-      else if (inst.dstReg == 1) {
-        inst.mnemonic = "or";
-      }
-      else if (inst.dstReg == 2) {
-        inst.mnemonic = "adc"; // Add with carry
-      }
-      else if (inst.dstReg == 3) {
-        inst.mnemonic = "sbb"; // Integer subtraction with borrow
-      }
-      else if (inst.dstReg == 4) {
-        inst.mnemonic = "and";
-      }
-      else if (inst.dstReg == 5) {
-        inst.mnemonic = "sub";
-      }
-      else if (inst.dstReg == 6) {
-        inst.mnemonic = "xor";
-      }
-      else if (inst.dstReg == 7) {
-        inst.mnemonic = "cmp";
-      }
-
-      addResult(inst, pos, result);
-    }
-
-    // ADD, OR, ADC, SBB, AND, SUB, XOR, CMP
-    // (r/m16/32	imm16/32)
-    else if (ch == 0x81 && peek) {
-      processModRegRM(inst, true);
-
-      inst.immSrc = true;
-      processImm32(inst);
-
-      // Don't display the 'dst' after the 'src'.
-      inst.dstRegSet = false;
-
-      if (inst.dstReg == 0) {
-        inst.mnemonic = "add";
-      }
-      else if (inst.dstReg == 1) {
-        inst.mnemonic = "or";
-      }
-      else if (inst.dstReg == 2) {
-        inst.mnemonic = "adc"; // Add with carry
-      }
-      else if (inst.dstReg == 3) {
-        inst.mnemonic = "sbb"; // Integer subtraction with borrow
-      }
-      else if (inst.dstReg == 4) {
-        inst.mnemonic = "and";
-      }
-      else if (inst.dstReg == 5) {
-        inst.mnemonic = "sub";
-      }
-      else if (inst.dstReg == 6) {
-        inst.mnemonic = "xor";
-      }
-      else if (inst.dstReg == 7) {
-        inst.mnemonic = "cmp";
-      }
-
-      addResult(inst, pos, result);
-    }
+  bool any = (getReported() > 0 || !result.isEmpty());
+  if (!reportBatch(result, getPos(), true)) {
+    return false;
+  }
+  return any;
+}
 
-    // ADD, OR, ADC, SBB, AND, SUB, XOR, CMP
-    // (r/m16/32	imm8)
-    else if (ch == 0x83 && peek) {
-      processModRegRM(inst, true);
+void AsmX86::begin(SectionPtr sec) {
+  this->sec = sec;
+  size = sec->getDataSize();
+  base = 0;
+  data.clear();
+  reader.reset(new Reader(data.constData(), 0));
+  fillWindow();
 
-      inst.immSrc = true;
-      processImm8(inst);
+  // Address of main()
+  funcAddr = sec->getAddress();
+  _64 = (obj->getSystemBits() == 64);
+}
 
-      // Don't display the 'dst' after the 'src'.
-      inst.dstRegSet = false;
+void AsmX86::fillWindow() {
+  // Enough for the longest instruction after any number of prefixes
+  // the NOP handling eats.
+  const qint64 minLeft = 64;
 
-      if (inst.dstReg == 0) {
-        inst.mnemonic = "add";
-      }
-      else if (inst.dstReg == 1) {
-        inst.mnemonic = "or";
-      }
-      else if (inst.dstReg == 2) {
-        inst.mnemonic = "adc"; // Add with carry
-      }
-      else if (inst.dstReg == 3) {
-        inst.mnemonic = "sbb"; // Integer subtraction with borrow
-      }
-      else if (inst.dstReg == 4) {
-        inst.mnemonic = "and";
-      }
-      else if (inst.dstReg == 5) {
-        inst.mnemonic = "sub";
-      }
-      else if (inst.dstReg == 6) {
-        inst.mnemonic = "xor";
-      }
-      else if (inst.dstReg == 7) {
-        inst.mnemonic = "cmp";
-      }
-
-      addResult(inst, pos, result);
-    }
+  qint64 pos = getPos();
+  if (base + data.size() - pos >= minLeft || base + data.size() >= size) {
+    return;
+  }
 
-    // TEST (r/m16/32  r16/32)
-    else if (ch == 0x85 && peek) {
-      inst.mnemonic = "test";
-      processModRegRM(inst);
-      inst.reverse();
-      addResult(inst, pos, result);
-    }
+  // Only a window of the section is read at a time so memory use doesn't
+  // depend on its size. It refers to the section bytes without copying
+  // unless edited.
+  base = pos;
+  data = sec->read(base, qMin<qint64>(windowSize, size - base));
+  reader.reset(new Reader(data.constData(), data.size()));
+}
 
-    // MOV (r/m8	r8) (reverse of 0x8A)
-    else if (ch == 0x88 && peek) {
-      inst.mnemonic = "mov";
-      inst.dataType = DataType::Byte;
-      inst.srcRegType = inst.dstRegType = RegType::R8;
-      processModRegRM(inst);
-      inst.reverse();
-      addResult(inst, pos, result);
-    }
+bool AsmX86::step(Disassembly &result) {
+  if (!reader || atEnd()) {
+    return false;
+  }
+  fillWindow();
 
-    // MOV (r8  r/m8)
-    else if (ch == 0x8A && peek) {
-      inst.mnemonic = "mov";
-      inst.dataType = DataType::Byte;
-      inst.srcRegType = inst.dstRegType = RegType::R8;
-      processModRegRM(inst);
-      addResult(inst, pos, result);
-    }
+  // Handle special NOP sequences.
+  if (handleNops(result)) {
+    return true;
+  }
 
-    // MOV (r16/32	r/m16/32)
-    else if (ch == 0x8B && peek) {
-      inst.mnemonic = "mov";
-      processModRegRM(inst);
-      addResult(inst, pos, result);
-    }
+  bool ok{true}, peek{false};
+  qint64 pos = instPos = getPos();
+  unsigned char ch = reader->getUChar(&ok);
+  if (!ok) return false;
 
-    // LEA (r16/32	m) Load Effective Address
-    else if (ch == 0x8D && peek) {
-      inst.mnemonic = "lea";
-      processModRegRM(inst);
-      addResult(inst, pos, result);
-    }
+  unsigned char nch = reader->peekUChar(&peek);
 
-    // MOV (r/m16/32  r16/32) (reverse of 0x8B)
-    else if (ch == 0x89 && peek) {
-      inst.mnemonic = "mov";
-      processModRegRM(inst);
-      inst.reverse();
-      addResult(inst, pos, result);
-    }
+  // Instruction to fill.
+  Instruction inst;
+  inst.dataType = DataType::Doubleword;
+  inst.srcRegType = inst.dstRegType = (_64 ? RegType::R64 : RegType::R32);
 
-    // NOP
-    else if (ch == 0x90) {
-      addResult("nop", pos, result);
+  // REX mode (64-bit ONLY!).
+  if (_64 && ch >= 0x40 && ch <= 0x4F) {
+    // W=1 => 64-bit
+    // R=1 => Extension to Mod-R/M: reg
+    // X=1 => Extension to SIB index
+    // B=1 => Extension to Mod-R/M: R/M oR SIB base
+    splitRex(ch, inst.rexW, inst.rexR, inst.rexX, inst.rexB);
+    if (inst.rexW) {
+      inst.dataType = DataType::Quadword;
     }
 
-    // TEST	(AL	imm8)
-    else if (ch == 0xA8 && peek) {
-      inst.mnemonic = "testb";
-      inst.disp = reader->getUChar();
-      inst.dispBytes = 1;
-      inst.dispSrc = true;
-
-      // Dst is always %al.
-      inst.dstReg = 0;
-      inst.dstRegSet = true;
-      inst.dstRegType = RegType::R8;
-      inst.srcRegType = RegType::R8;
-
-      addResult(inst, pos, result);
+    // Setup for next. A prefix at the end is only data.
+    ch = reader->getUChar(&ok);
+    if (!ok) {
+      addData(data.constData() + pos - base, getPos() - pos, pos, result);
+      return true;
     }
 
-    // MOV (r8  imm8)
-    else if (ch >= 0xB0 && ch <= 0xB7) {
-      inst.mnemonic = "mov";
-      inst.dataType = DataType::Byte;
-      inst.srcReg = getR(ch);
-      inst.srcRegType = RegType::R8;
-      inst.srcRegSet = true;
+    nch = reader->peekUChar(&peek);
+  }
 
-      inst.immSrc = true;
-      processImm8(inst);
+  // Two-byte instructions.
+  const OpEntry *map = primaryMap;
+  bool twoByte{false};
+  if (ch == 0x0F && peek) {
+    ch = nch;
+    reader->getUChar(); // eat
 
-      addResult(inst, pos, result);
-    }
+    nch = reader->peekUChar(&peek);
+    map = secondaryMap;
+    twoByte = true;
+  }
 
-    // MOV (r16/32  imm16/32)
-    else if (ch >= 0xB8 && ch <= 0xBF) {
-      inst.mnemonic = "mov";
-      inst.srcReg = getR(ch);
-      inst.srcRegSet = true;
+  // Jump straight to the operand decoding routine of the opcode.
+  const OpEntry &entry = map[ch];
+  quint16 id = (twoByte ? TwoByteOp : 0) + ch;
+  if (entry.handler && (peek || !(entry.flags & NeedsNext))) {
+    reader->resetFailed();
+    (this->*entry.handler)(ch, entry, inst);
 
-      inst.immSrc = true;
-      if (inst.dataType == DataType::Quadword) {
-        processImm64(inst);
-      }
-      else {
-        processImm32(inst);
-      }
-
-      addResult(inst, pos, result);
+    // Operands cut off by the end of the section are only data. A read
+    // that runs out leaves the reader at the end of the section.
+    if (reader->hasFailed()) {
+      addData(data.constData() + pos - base, getPos() - pos, pos, result);
+      return true;
     }
+    addResult(id, inst, pos, result);
+  }
 
-    // ROL, ROR, RCL, RCR, SHL/SAL, SHR, SAL/SHL, SAR
-    // (r/m16/32  imm8)
-    else if (ch == 0xC1) {
-      processModRegRM(inst, true);
+  // Unsupported
+  else {
+    addResult(UnsupportedOp + id, pos, result);
+  }
+  return true;
+}
 
-      inst.immSrc = true;
-      processImm8(inst);
+bool AsmX86::handleNops(Disassembly &result) {
+  qint64 pos = getPos();
 
-      // Don't display the 'dst' after the 'src'.
-      inst.dstRegSet = false;
+  // Eat any 0x66's but leave one for the matching beneath.
+  while (reader->peekList({0x66, 0x66})) {
+    reader->read(1);
+    fillWindow();
+  }
 
-      if (inst.dstReg == 0) {
-        inst.mnemonic = "rol";
-      }
-      else if (inst.dstReg == 1) {
-        inst.mnemonic = "ror";
-      }
-      else if (inst.dstReg == 2) {
-        inst.mnemonic = "rcl";
-      }
-      else if (inst.dstReg == 3) {
-        inst.mnemonic = "rcr";
-      }
-      else if (inst.dstReg == 4) {
-        inst.mnemonic = "shl";
-      }
-      else if (inst.dstReg == 5) {
-        inst.mnemonic = "shr";
-      }
-      else if (inst.dstReg == 6) {
-        inst.mnemonic = "sal";
-      }
-      else if (inst.dstReg == 7) {
-        inst.mnemonic = "sar";
-      }
+  if (reader->peekList({0x66, 0x2e, 0x0f, 0x1f, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00})) {
+    reader->read(10);
+    addResult(NopOp + 0, pos, result);
+  }
+  else if (reader->peekList({0x66, 0x0f, 0x1f, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00})) {
+    reader->read(9);
+    addResult(NopOp + 1, pos, result);
+  }
+  else if (reader->peekList({0x0f, 0x1f, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00})) {
+    reader->read(8);
+    addResult(NopOp + 2, pos, result);
+  }
+  else if (reader->peekList({0x0f, 0x1f, 0x80, 0x00, 0x00, 0x00, 0x00})) {
+    reader->read(7);
+    addResult(NopOp + 3, pos, result);
+  }
+  else if (reader->peekList({0x66, 0x0f, 0x1f, 0x44, 0x00, 0x00})) {
+    reader->read(6);
+    addResult(NopOp + 4, pos, result);
+  }
+  else if (reader->peekList({0x0f, 0x1f, 0x44, 0x00, 0x00})) {
+    reader->read(5);
+    addResult(NopOp + 5, pos, result);
+  }
+  else if (reader->peekList({0x0f, 0x1f, 0x00})) {
+    reader->read(3);
+    addResult(NopOp + 6, pos, result);
+  }
+  else if (reader->peekList({0x66, 0x90})) {
+    reader->read(2);
+    addResult(NopOp + 7, pos, result);
+  }
+  else {
+    return false;
+  }
+  return true;
+}
 
-      addResult(inst, pos, result);
-    }
+void AsmX86::addData(const char *bytes, int size, quint32 offset,
+                     Disassembly &result) {
+  // Up to 8 bytes per line kept as the immediate.
+  for (int i = 0; i < size; i += 8) {
+    int len = qMin(8, size - i);
+    Disassembly::Operands ops = Disassembly::Operands();
+    for (int j = 0; j < len; j++) {
+      ops.imm |= quint64((uchar) bytes[i + j]) << (j * 8);
+    }
+    ops.immBytes = len;
+    result.append(offset + i, len, DataOp, ops);
+  }
+}
 
-    // RETN
-    else if (ch == 0xC3) {
-      addResult("ret", pos, result);
+void AsmX86::render(const Disassembly &result, int index,
+                    QString &out) const {
+  quint16 id = result.getOpcode(index);
+  if (id == DataOp) {
+    const auto &ops = result.getOperands(index);
+    out += "Data:";
+    for (int i = 0; i < ops.immBytes; i++) {
+      uchar byte = (ops.imm >> (i * 8)) & 0xFF;
+      out += ' ';
+      out += QString::number(byte, 16).toUpper().rightJustified(2, '0');
     }
-
-    // MOV (r/m8  imm8)
-    else if (ch == 0xC6 && peek) {
-      inst.mnemonic = "mov";
-      inst.dataType = DataType::Byte;
-      inst.dstRegType = RegType::R8;
-      processModRegRM(inst);
-      inst.reverse();
-
-      inst.immSrc = true;
-      inst.srcRegSet = false;
-      processImm8(inst);
-
-      addResult(inst, pos, result);
+  }
+  else if (id >= UnsupportedOp) {
+    id -= UnsupportedOp;
+    out += "Unsupported: ";
+    if (id >= TwoByteOp) {
+      out += "F ";
     }
+    out += QString::number(id & 0xFF, 16).toUpper();
+  }
+  else if (id >= NopOp) {
+    out += nops[id - NopOp];
+  }
+  else {
+    Instruction inst(result.getOperands(index));
+    inst.mnemonic = getMnemonic(id, inst);
+    inst.toString(obj, out);
+  }
+}
 
-    // MOV (r/m16/32	imm16/32)
-    else if (ch == 0xC7 && peek) {
-      inst.mnemonic = "mov";
-      processModRegRM(inst);
-      inst.reverse();
-
-      inst.immSrc = true;
-      inst.srcRegSet = false;
-      processImm32(inst);
-
-      addResult(inst, pos, result);
-    }
+const char *AsmX86::getMnemonic(quint16 id, const Instruction &inst) {
+  const OpEntry &entry =
+    (id >= TwoByteOp ? secondaryMap[id - TwoByteOp] : primaryMap[id]);
+  if (entry.mnemonic) {
+    return entry.mnemonic;
+  }
 
-    // Call (relative function address)
-    else if (ch == 0xE8) {
-      inst.mnemonic = "call";
-      inst.disp = reader->getUInt32();
-      inst.dispBytes = 4;
-      inst.dispDst = true;
-      inst.offset = funcAddr + reader->pos();
-      inst.call = true;
-      if (_64) inst.dataType = DataType::Quadword;
-      addResult(inst, pos, result);
-    }
+  // Groups are selected by the Mod-R/M reg field, kept in dstReg.
+  if (entry.handler == &AsmX86::decodeGroup1 && inst.dstReg < 8) {
+    return group1[inst.dstReg];
+  }
+  if (entry.handler == &AsmX86::decodeGroup2 && inst.dstReg < 8) {
+    return group2[inst.dstReg];
+  }
+  if (entry.handler == &AsmX86::decodeGroup5 && inst.dstReg < 7) {
+    return group5[inst.dstReg];
+  }
+  return nullptr;
+}
 
-    // JMP (rel16/32) (relative address)
-    else if (ch == 0xE9) {
-      inst.mnemonic = "jmp";
-      inst.dataType = DataType::None;
-      inst.disp = reader->getUInt32();
-      inst.dispBytes = 4;
-      inst.dispDst = true;
-      inst.offset = funcAddr + reader->pos();
-      addResult(inst, pos, result);
-    }
+void AsmX86::addResult(quint16 id, const Instruction &inst, qint64 pos,
+                       Disassembly &result) {
+  result.append(pos, getPos() - pos, id, inst.getOperands());
+}
 
-    // JMP (rel8)
-    else if (ch == 0xEB && peek) {
-      inst.mnemonic = "jmp";
-      inst.dataType = DataType::None;
-      inst.disp = reader->getUChar();
-      inst.dispBytes = 1;
-      inst.dispDst = true;
-      inst.offset = funcAddr + reader->pos();
-      addResult(inst, pos, result);
-    }
+void AsmX86::addResult(quint16 id, qint64 pos, Disassembly &result) {
+  result.append(pos, getPos() - pos, id, Disassembly::Operands());
+}
 
-    // HLT
-    else if (ch == 0xF4) {
-      addResult("hlt", pos, result);
-    }
+void AsmX86::decodeFixed(unsigned char op, const OpEntry &entry,
+                         Instruction &inst) {
+  // Mnemonic only, like NOP, RETN and HLT.
+  inst.dataType = DataType::None;
+}
 
-    // INC, DEC, CALL, CALLF, JMP, JMPF, PUSH
-    else if (ch == 0xFF && peek) {
-      processModRegRM(inst, true);
+void AsmX86::decodeModRM(unsigned char op, const OpEntry &entry,
+                         Instruction &inst) {
+  if (entry.flags & Byte) {
+    inst.dataType = DataType::Byte;
+    inst.srcRegType = inst.dstRegType = RegType::R8;
+  }
+  processModRegRM(inst);
+  if (entry.flags & Reverse) {
+    inst.reverse();
+  }
+  if (entry.flags & SrcOnly) {
+    inst.dstRegSet = false;
+  }
+}
 
-      // Don't display the 'dst' after the 'src'.
-      inst.dstRegSet = false;
+void AsmX86::decodeAccImm(unsigned char op, const OpEntry &entry,
+                          Instruction &inst) {
+  if (entry.flags & Byte) {
+    inst.dataType = DataType::Byte;
+    inst.srcRegType = inst.dstRegType = RegType::R8;
+    inst.imm = reader->getUChar();
+    inst.immBytes = 1;
+  }
+  else {
+    inst.imm = reader->getUInt32();
+    inst.immBytes = 4;
+  }
+  inst.immSrc = true;
 
-      if (inst.dstReg == 0) {
-        inst.mnemonic = "inc";
-        inst.dataType = DataType::None;
-      }
-      else if (inst.dstReg == 1) {
-        inst.mnemonic = "dec";
-        inst.dataType = DataType::None;
-      }
-      else if (inst.dstReg == 2) {
-        inst.mnemonic = "call *";
-        inst.call = true;
-        inst.dataType = DataType::None;
-      }
-      else if (inst.dstReg == 3) {
-        inst.mnemonic = "callf";
-        inst.call = true;
-        inst.dataType = DataType::None;
-      }
-      else if (inst.dstReg == 4) {
-        inst.mnemonic = "jmp *";
-        inst.dataType = DataType::None;
-      }
-      else if (inst.dstReg == 5) {
-        inst.mnemonic = "jmpf";
-        inst.dataType = DataType::None;
-      }
-      else if (inst.dstReg == 6) {
-        inst.mnemonic = "push";
-        if (_64) inst.dataType = DataType::Quadword;
-      }
+  // Dst is always %al/%eax.
+  inst.dstReg = 0;
+  inst.dstRegSet = true;
+}
 
-      addResult(inst, pos, result);
-    }
+void AsmX86::decodeStackReg(unsigned char op, const OpEntry &entry,
+                            Instruction &inst) {
+  if (_64) inst.dataType = DataType::Quadword;
+  inst.srcReg = getR(op);
+  inst.srcRegSet = true;
+}
 
-    // Two-byte instructions.
-    else if (ch == 0x0F && peek) {
-      ch = nch;
-      reader->getUChar(); // eat
+void AsmX86::decodePushImm(unsigned char op, const OpEntry &entry,
+                           Instruction &inst) {
+  if (_64) inst.dataType = DataType::Quadword;
+  inst.immDst = true;
+  inst.dstRegSet = false;
+  processImm8(inst);
+}
 
-      nch = reader->peekUChar(&peek);
+void AsmX86::decodeIns(unsigned char op, const OpEntry &entry,
+                       Instruction &inst) {
+  inst.dataType = DataType::Byte;
+  processModRegRM(inst);
 
-      // NOP (r/m16/32)
-      if (ch == 0x1F && peek) {
-        inst.mnemonic = "nop";
-        processModRegRM(inst);
-        inst.dstRegSet = false;
-        addResult(inst, pos, result);
-      }
+  // Src is always %dx/dl
+  inst.srcReg = 2;
+  inst.srcRegType = RegType::R8;
+  inst.srcRegSet = true;
+}
 
-      // JNB (rel16/32), JAE (rel16/32), or JNC (rel16/32).
-      else if (ch == 0x83) {
-        inst.mnemonic = "jae";
-        inst.disp = reader->getUInt32();
-        inst.dispBytes = 4;
-        inst.dispDst = true;
-        inst.offset = funcAddr + reader->pos();
-        inst.dataType = DataType::None;
-        addResult(inst, pos, result);
-      }
+void AsmX86::decodeJneRel8(unsigned char op, const OpEntry &entry,
+                           Instruction &inst) {
+  // Short jump
+  inst.disp = instPos - (255 - (int) reader->getUChar()) + 1;
+  inst.dispBytes = 1;
+  inst.dispDst = true;
+  inst.offset = funcAddr;
+  inst.dataType = DataType::None;
+}
 
-      // JZ (rel16/32) or JE (rel16/32), same functionality different
-      // name. Relative function address.
-      else if (ch == 0x84) {
-        inst.mnemonic = "je";
-        inst.disp = reader->getUInt32();
-        inst.dispBytes = 4;
-        inst.dispDst = true;
-        inst.offset = funcAddr + reader->pos();
-        inst.dataType = DataType::None;
-        addResult(inst, pos, result);
-      }
+void AsmX86::decodeJmpRel(unsigned char op, const OpEntry &entry,
+                          Instruction &inst) {
+  inst.dataType = DataType::None;
+  if (entry.flags & Imm8) {
+    inst.disp = reader->getUChar();
+    inst.dispBytes = 1;
+  }
+  else {
+    inst.disp = reader->getUInt32();
+    inst.dispBytes = 4;
+  }
+  inst.dispDst = true;
+  inst.offset = funcAddr + getPos();
+}
 
-      // JNZ (rel16/32) or JNE (rel16/32), same functionality
-      // different name. Relative function address.
-      else if (ch == 0x85) {
-        inst.mnemonic = "jne";
-        inst.disp = reader->getUInt32();
-        inst.dispBytes = 4;
-        inst.dispDst = true;
-        inst.offset = funcAddr + reader->pos();
-        inst.dataType = DataType::None;
-        addResult(inst, pos, result);
-      }
+void AsmX86::decodeCall(unsigned char op, const OpEntry &entry,
+                        Instruction &inst) {
+  // Relative function address.
+  inst.disp = reader->getUInt32();
+  inst.dispBytes = 4;
+  inst.dispDst = true;
+  inst.offset = funcAddr + getPos();
+  inst.call = true;
+  if (_64) inst.dataType = DataType::Quadword;
+}
 
-      // JA (rel16/32) or JNBE (rel16/32)
-      else if (ch == 0x87) {
-        inst.mnemonic = "ja";
-        inst.disp = reader->getUInt32();
-        inst.dispBytes = 4;
-        inst.dispDst = true;
-        inst.offset = funcAddr + reader->pos();
-        inst.dataType = DataType::None;
-        addResult(inst, pos, result);
-      }
+void AsmX86::decodeGroup1(unsigned char op, const OpEntry &entry,
+                          Instruction &inst) {
+  if (entry.flags & Byte) {
+    inst.dataType = DataType::Byte;
+    inst.srcRegType = inst.dstRegType = RegType::R8;
+  }
+  processModRegRM(inst, true);
 
-      // JNL (rel16/32) or JGE (rel16/32).
-      else if (ch == 0x8D) {
-        inst.mnemonic = "jge";
-        inst.disp = reader->getUInt32();
-        inst.dispBytes = 4;
-        inst.dispDst = true;
-        inst.offset = funcAddr + reader->pos();
-        inst.dataType = DataType::None;
-        addResult(inst, pos, result);
-      }
+  inst.immSrc = true;
+  if (entry.flags & Imm8) {
+    processImm8(inst);
+  }
+  else {
+    processImm32(inst);
+  }
 
-      // JLE (rel16/32) or JNG (rel16/32), same functionality
-      // different name. Relative function address.
-      else if (ch == 0x8E) {
-        inst.mnemonic = "jle";
-        inst.disp = reader->getUInt32();
-        inst.dispBytes = 4;
-        inst.dispDst = true;
-        inst.offset = funcAddr + reader->pos();
-        inst.dataType = DataType::None;
-        addResult(inst, pos, result);
-      }
+  // Don't display the 'dst' after the 'src'.
+  inst.dstRegSet = false;
+}
 
-      // JNLE (rel16/32) or JG (rel16/32).
-      else if (ch == 0x8F) {
-        inst.mnemonic = "jg";
-        inst.disp = reader->getUInt32();
-        inst.dispBytes = 4;
-        inst.dispDst = true;
-        inst.offset = funcAddr + reader->pos();
-        inst.dataType = DataType::None;
-        addResult(inst, pos, result);
-      }
+void AsmX86::decodeGroup2(unsigned char op, const OpEntry &entry,
+                          Instruction &inst) {
+  processModRegRM(inst, true);
 
-      // SETZ (r/m8) or SETE (r/m8)
-      else if (ch == 0x94 && peek) {
-        inst.mnemonic = "sete";
-        inst.srcRegType = RegType::R8;
-        processModRegRM(inst);
-        inst.dstRegSet = false;
-        addResult(inst, pos, result);
-      }
+  inst.immSrc = true;
+  processImm8(inst);
 
-      // SETNZ (r/m8) or SETNE (r/m8).
-      else if (ch == 0x95 && peek) {
-        inst.mnemonic = "setne";
-        inst.srcRegType = RegType::R8;
-        processModRegRM(inst);
-        inst.dstRegSet = false;
-        addResult(inst, pos, result);
-      }
+  // Don't display the 'dst' after the 'src'.
+  inst.dstRegSet = false;
+}
 
-      // MOVZX (r16/32 r/m8)
-      // Move with Zero-Extension
-      else if (ch == 0xB6) {
-        inst.mnemonic = "movzb";
-        processModRegRM(inst);
-        addResult(inst, pos, result);
-      }
+void AsmX86::decodeGroup5(unsigned char op, const OpEntry &entry,
+                          Instruction &inst) {
+  processModRegRM(inst, true);
 
-      // MOVSX (r16/32 r/m8)
-      // Move with Sign-Extension
-      else if (ch == 0xBE && peek) {
-        inst.mnemonic = "movsb";
-        processModRegRM(inst);
-        addResult(inst, pos, result);
-      }
-    }
+  // Don't display the 'dst' after the 'src'.
+  inst.dstRegSet = false;
 
-    // Unsupported
-    else {
-      addResult("Unsupported: " + QString::number(ch, 16).toUpper(),
-                pos, result);
-    }
+  // CALL, CALLF
+  if (inst.dstReg == 2 || inst.dstReg == 3) {
+    inst.call = true;
   }
 
-  return !result.asmLines.isEmpty();
+  // PUSH
+  if (inst.dstReg == 6) {
+    if (_64) inst.dataType = DataType::Quadword;
+  }
+  else if (inst.dstReg < 6) {
+    inst.dataType = DataType::None;
+  }
 }
 
-bool AsmX86::handleNops(Disassembly &result) {
-  qint64 pos = reader->pos();
+void AsmX86::decodeTestAlImm(unsigned char op, const OpEntry &entry,
+                             Instruction &inst) {
+  inst.disp = reader->getUChar();
+  inst.dispBytes = 1;
+  inst.dispSrc = true;
 
-  // Eat any 0x66's but leave one for the matching beneath.
-  while (reader->peekList({0x66, 0x66})) {
-    reader->read(1);
-  }
+  // Dst is always %al.
+  inst.dstReg = 0;
+  inst.dstRegSet = true;
+  inst.dstRegType = RegType::R8;
+  inst.srcRegType = RegType::R8;
+}
 
-  if (reader->peekList({0x66, 0x2e, 0x0f, 0x1f, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00})) {
-    reader->read(10);
-    addResult("nopw %cs:0L(%eax,%eax,1)", pos, result);
-  }
-  else if (reader->peekList({0x66, 0x0f, 0x1f, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00})) {
-    reader->read(9);
-    addResult("nopw 0L(%eax,%eax,1)", pos, result);
+void AsmX86::decodeMovRegImm(unsigned char op, const OpEntry &entry,
+                             Instruction &inst) {
+  inst.srcReg = getR(op);
+  inst.srcRegSet = true;
+  inst.immSrc = true;
+  if (entry.flags & Byte) {
+    inst.dataType = DataType::Byte;
+    inst.srcRegType = RegType::R8;
+    processImm8(inst);
   }
-  else if (reader->peekList({0x0f, 0x1f, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00})) {
-    reader->read(8);
-    addResult("nopl 0L(%eax,%eax,1)", pos, result);
-  }
-  else if (reader->peekList({0x0f, 0x1f, 0x80, 0x00, 0x00, 0x00, 0x00})) {
-    reader->read(7);
-    addResult("nopl 0L(%eax)", pos, result);
+  else if (inst.dataType == DataType::Quadword) {
+    processImm64(inst);
   }
-  else if (reader->peekList({0x66, 0x0f, 0x1f, 0x44, 0x00, 0x00})) {
-    reader->read(6);
-    addResult("nopw 0x0(%eax,%eax,1)", pos, result);
-  }
-  else if (reader->peekList({0x0f, 0x1f, 0x44, 0x00, 0x00})) {
-    reader->read(5);
-    addResult("nopl 0x0(%eax,%eax,1)", pos, result);
+  else {
+    processImm32(inst);
   }
-  else if (reader->peekList({0x0f, 0x1f, 0x00})) {
-    reader->read(3);
-    addResult("nopl 0x0(%eax)", pos, result);
+}
+
+void AsmX86::decodeMovRmImm(unsigned char op, const OpEntry &entry,
+                            Instruction &inst) {
+  if (entry.flags & Byte) {
+    inst.dataType = DataType::Byte;
+    inst.dstRegType = RegType::R8;
   }
-  else if (reader->peekList({0x66, 0x90})) {
-    reader->read(2);
-    addResult("xchg %ax,%ax", pos, result);
+  processModRegRM(inst);
+  inst.reverse();
+
+  inst.immSrc = true;
+  inst.srcRegSet = false;
+  if (entry.flags & Byte) {
+    processImm8(inst);
   }
   else {
-    return false;
+    processImm32(inst);
   }
-  return true;
 }
 
-void AsmX86::addResult(const Instruction &inst, qint64 pos,
-                       Disassembly &result) {
-  addResult(inst.toString(obj), pos, result);
-}
-
-void AsmX86::addResult(const QString &line, qint64 pos,
-                       Disassembly &result) {
-  result.asmLines << line;
-  result.bytesConsumed << reader->pos() - pos;
+void AsmX86::decodeSetcc(unsigned char op, const OpEntry &entry,
+                         Instruction &inst) {
+  inst.srcRegType = RegType::R8;
+  processModRegRM(inst);
+  inst.dstRegSet = false;
 }
 
 void AsmX86::splitByte(unsigned char num, unsigned char &mod, unsigned char &op1,
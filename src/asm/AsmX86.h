@@ -28,7 +28,7 @@ namespace {
   class Instruction {
   public:
     Instruction()
-      : dataType{DataType::Doubleword}, srcReg{0}, dstReg{0}, srcRegSet{false},
+      : mnemonic{nullptr}, dataType{DataType::Doubleword}, srcReg{0}, dstReg{0}, srcRegSet{false},
       dstRegSet{false}, srcRegType{RegType::R32}, dstRegType{RegType::R32},
       scale{0}, index{0}, base{0}, sipSrc{false}, sipDst{false}, disp{0},
       imm{0}, dispSrc{false}, dispDst{false}, immSrc{false}, immDst{false},
@@ -36,7 +36,12 @@ namespace {
       rexR{false}, rexX{false}, rexB{false}
     { }
 
-    QString toString(BinaryObjectPtr obj) const;
+    // Decoded operands as stored in a Disassembly.
+    explicit Instruction(const Disassembly::Operands &ops);
+    Disassembly::Operands getOperands() const;
+
+    // Append the instruction in AT&T syntax to str.
+    void toString(BinaryObjectPtr obj, QString &str) const;
     void reverse();
 
   private:
@@ -48,7 +53,7 @@ namespace {
     QString formatHex(quint64 num, int len = 2) const;
 
   public:
-    QString mnemonic;
+    const char *mnemonic;
     DataType dataType;
     unsigned char srcReg, dstReg;
     bool srcRegSet, dstRegSet;
@@ -68,11 +73,81 @@ class AsmX86 : public Asm {
 public:
   AsmX86(BinaryObjectPtr obj);
   bool disassemble(SectionPtr sec, Disassembly &result);
+  void begin(SectionPtr sec);
+  bool step(Disassembly &result);
+  void addData(const char *bytes, int size, quint32 offset,
+               Disassembly &result);
+  void render(const Disassembly &result, int index, QString &out) const;
 
 private:
+  /**
+   * IDs of decoded instructions. One-byte opcodes are their own ID and
+   * two-byte opcodes are offset by TwoByteOp. The rest are lines
+   * without an opcode entry.
+   */
+  enum : quint16 {
+    TwoByteOp = 0x100,
+    NopOp = 0x200, // + index of the special NOP sequence
+    UnsupportedOp = 0x300, // + opcode ID of the unsupported opcode
+    DataOp = 0x500 // Bytes that aren't an instruction, see addData().
+  };
+
+  // Operand decoding routine of an opcode.
+  struct OpEntry;
+  typedef void (AsmX86::*OpHandler)(unsigned char op, const OpEntry &entry,
+                                    Instruction &inst);
+
+  enum OpFlag : int {
+    NeedsNext = 0x1, // Only valid if followed by another byte.
+    Reverse = 0x2, // Swap src and dst after decoding Mod-R/M.
+    Byte = 0x4, // 8-bit operands.
+    Imm8 = 0x8, // 8-bit immediate or relative address.
+    SrcOnly = 0x10 // Don't display the 'dst' after the 'src'.
+  };
+
+  struct OpEntry {
+    OpHandler handler;
+    const char *mnemonic;
+    int flags;
+  };
+
+  // Opcode maps indexed by the opcode byte. Entries without a handler
+  // are unsupported.
+  static const OpEntry primaryMap[256]; // One-byte opcodes.
+  static const OpEntry secondaryMap[256]; // Two-byte opcodes (0x0F xx).
+
   bool handleNops(Disassembly &result);
-  void addResult(const Instruction &inst, qint64 pos, Disassembly &result);
-  void addResult(const QString &inst, qint64 pos, Disassembly &result);
+  void addResult(quint16 id, const Instruction &inst, qint64 pos,
+                 Disassembly &result);
+  void addResult(quint16 id, qint64 pos, Disassembly &result);
+
+  // Mnemonic of the instruction with the ID, some of which depend on
+  // the Mod-R/M reg field.
+  static const char *getMnemonic(quint16 id, const Instruction &inst);
+
+  // Operand decoding routines.
+  void decodeFixed(unsigned char op, const OpEntry &entry, Instruction &inst);
+  void decodeModRM(unsigned char op, const OpEntry &entry, Instruction &inst);
+  void decodeAccImm(unsigned char op, const OpEntry &entry, Instruction &inst);
+  void decodeStackReg(unsigned char op, const OpEntry &entry,
+                      Instruction &inst);
+  void decodePushImm(unsigned char op, const OpEntry &entry,
+                     Instruction &inst);
+  void decodeIns(unsigned char op, const OpEntry &entry, Instruction &inst);
+  void decodeJneRel8(unsigned char op, const OpEntry &entry,
+                     Instruction &inst);
+  void decodeJmpRel(unsigned char op, const OpEntry &entry, Instruction &inst);
+  void decodeCall(unsigned char op, const OpEntry &entry, Instruction &inst);
+  void decodeGroup1(unsigned char op, const OpEntry &entry, Instruction &inst);
+  void decodeGroup2(unsigned char op, const OpEntry &entry, Instruction &inst);
+  void decodeGroup5(unsigned char op, const OpEntry &entry, Instruction &inst);
+  void decodeTestAlImm(unsigned char op, const OpEntry &entry,
+                       Instruction &inst);
+  void decodeMovRegImm(unsigned char op, const OpEntry &entry,
+                       Instruction &inst);
+  void decodeMovRmImm(unsigned char op, const OpEntry &entry,
+                      Instruction &inst);
+  void decodeSetcc(unsigned char op, const OpEntry &entry, Instruction &inst);
 
   // Split byte into [2][3][3] bits.
   void splitByte(unsigned char num, unsigned char &mod, unsigned char &op1,
@@ -92,8 +167,27 @@ private:
   void processImm32(Instruction &inst);
   void processImm64(Instruction &inst);
 
+  // Position in the section and whether all of it is decoded.
+  qint64 getPos() const { return base + reader->pos(); }
+  bool atEnd() const { return getPos() >= size; }
+
+  // Read the next window of the section if little is left of this one.
+  void fillWindow();
+
+  static const int windowSize = 1024 * 1024;
+
   BinaryObjectPtr obj;
+  SectionPtr sec;
+
+  // Window of the section being decoded and its offset.
+  QByteArray data;
+  qint64 base, size;
   ReaderPtr reader;
+
+  // State of the instruction being decoded.
+  quint64 funcAddr;
+  qint64 instPos;
+  bool _64;
 };
 
 #endif // BMOD_ASM_X86_H
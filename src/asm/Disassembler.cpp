@@ -1,19 +1,27 @@
+#include <QMutex>
+#include <QAtomicInt>
 #include <QByteArray>
 
+#include <memory>
+#include <vector>
+#include <algorithm>
+
 #include "Asm.h"
 #include "AsmX86.h"
 #include "../Util.h"
+#include "../Parallel.h"
 #include "Disassembler.h"
 
-Disassembler::Disassembler(BinaryObjectPtr obj) : asm_{nullptr} {
-  switch (obj->getCpuType()) {
-  case CpuType::X86:
-  case CpuType::X86_64:
-    asm_ = new AsmX86(obj);
-    break;
+namespace {
+  // Chunks smaller than this aren't worth decoding on their own.
+  const quint32 minChunkSize = 64 * 1024;
 
-  default: break;
-  }
+  // Instructions decoded at a time when visiting.
+  const int visitWindow = 256;
+}
+
+Disassembler::Disassembler(BinaryObjectPtr obj) : obj{obj}, asm_{nullptr} {
+  asm_ = createAsm(obj);
 }
 
 Disassembler::~Disassembler() {
@@ -23,8 +31,23 @@ Disassembler::~Disassembler() {
   }
 }
 
+void Disassembler::setBatchFunc(BatchFunc func, int size) {
+  batchFunc = func;
+  if (asm_) {
+    asm_->setBatchFunc(func, size);
+  }
+}
+
 bool Disassembler::disassemble(SectionPtr sec, Disassembly &result) {
   if (!asm_) return false;
+
+  // Decode independent chunks in parallel if the section has known
+  // function boundaries.
+  auto chunks = splitSection(sec);
+  if (chunks.size() > 2) {
+    return disassembleChunks(sec, chunks, result);
+  }
+
   return asm_->disassemble(sec, result);
 }
 
@@ -42,3 +65,146 @@ bool Disassembler::disassemble(const QString &data, Disassembly &result,
     Util::hexToData(data.simplified().trimmed().replace(" ", ""));
   return disassemble(input, result, offset);
 }
+
+bool Disassembler::visit(SectionPtr sec, VisitFunc func) {
+  if (!asm_) return false;
+
+  asm_->begin(sec);
+  Disassembly window;
+  window.reserve(visitWindow);
+  bool more{true}, any{false};
+  while (more) {
+    window.clear();
+    while (window.size() < visitWindow && (more = asm_->step(window))) { }
+
+    for (int i = 0; i < window.size(); i++) {
+      any = true;
+      if (!func(window, i)) {
+        return false;
+      }
+    }
+  }
+  return any;
+}
+
+void Disassembler::render(const Disassembly &result, int index,
+                          QString &out) const {
+  // Keeps the capacity unlike clear().
+  out.resize(0);
+  if (asm_) {
+    asm_->render(result, index, out);
+  }
+}
+
+QString Disassembler::getText(const Disassembly &result) const {
+  QString text, line;
+  for (int i = 0; i < result.size(); i++) {
+    render(result, i, line);
+    if (i > 0) text += '\n';
+    text += line;
+  }
+  return text;
+}
+
+Asm *Disassembler::createAsm(BinaryObjectPtr obj) {
+  switch (obj->getCpuType()) {
+  case CpuType::X86:
+  case CpuType::X86_64:
+    return new AsmX86(obj);
+
+  default: break;
+  }
+  return nullptr;
+}
+
+QList<quint32> Disassembler::splitSection(SectionPtr sec) const {
+  QList<quint32> chunks;
+  const auto &starts = obj->getFunctionStarts();
+  quint32 size = sec->getDataSize();
+  int threads = Parallel::getThreadCount();
+  if (starts.isEmpty() || threads < 2 || size < 2 * minChunkSize) {
+    return chunks;
+  }
+
+  // Aim for several chunks per thread to even out the load.
+  quint32 target = qMax(minChunkSize, size / (threads * 8));
+
+  quint64 addr = sec->getAddress(), end = addr + size;
+  auto it = std::upper_bound(starts.begin(), starts.end(), addr);
+  quint32 last{0};
+  chunks << 0;
+  for (; it != starts.end() && *it < end; ++it) {
+    quint32 offset = *it - addr;
+    if (offset - last >= target && size - offset >= minChunkSize) {
+      chunks << offset;
+      last = offset;
+    }
+  }
+  chunks << size;
+  return chunks;
+}
+
+bool Disassembler::disassembleChunks(SectionPtr sec,
+                                     const QList<quint32> &chunks,
+                                     Disassembly &result) {
+  int count = chunks.size() - 1;
+
+  // Chunks are taken in order, and each one is reported as soon as it
+  // and all chunks before it are done, by whichever worker finished
+  // the last of them.
+  std::vector<Disassembly> results(count);
+  std::vector<bool> done(count, false);
+  QMutex mutex;
+  int next{0};
+  bool any{false};
+  QAtomicInt cancelled{0};
+
+  Parallel::run(count, [&](int i) {
+      if (cancelled.load()) return;
+
+      quint32 start = chunks[i], size = chunks[i + 1] - start;
+      auto part =
+        SectionPtr(new Section(sec->getType(), sec->getName(),
+                               sec->getAddress() + start, size,
+                               sec->getOffset() + start));
+
+      // Refers to the bytes of the section unless the chunk was edited.
+      QByteArray data = sec->read(start, size);
+      part->setData(data);
+
+      std::unique_ptr<Asm> chunkAsm(createAsm(obj));
+      auto &res = results[i];
+      bool complete = chunkAsm->disassemble(part, res);
+
+      // Bytes that didn't decode are kept as data so the chunks stay
+      // contiguous.
+      quint32 end = (res.isEmpty() ? 0 : res.getOffset(res.size() - 1) +
+                     res.getLength(res.size() - 1));
+      if (!complete && end < size) {
+        chunkAsm->addData(data.constData() + end, size - end, end, res);
+      }
+
+      QMutexLocker locker(&mutex);
+      done[i] = true;
+      if (cancelled.load()) return;
+
+      // Offsets of the chunks are relative to their start.
+      Disassembly merged;
+      int first = next;
+      for (; next < count && done[next]; next++) {
+        merged.appendAll(results[next], chunks[next]);
+        results[next] = Disassembly();
+      }
+      if (next == first) return;
+      any = any || !merged.isEmpty();
+
+      if (!batchFunc) {
+        result.appendAll(merged);
+      }
+      else if (!batchFunc(merged, chunks[next])) {
+        cancelled.store(1);
+      }
+    });
+
+  return any && !cancelled.load();
+}
@@ -2,34 +2,81 @@
 #define BMOD_DISASSEMBLER_H
 
 #include <QString>
-#include <QStringList>
 
+#include <functional>
+
+#include "Disassembly.h"
 #include "../BinaryObject.h"
 
 class Asm;
 class QByteArray;
 
-struct Disassembly {
-  // Machine code to assembly language.
-  QStringList asmLines;
-
-  // Bytes consumed per ASM line produced.
-  QList<short> bytesConsumed;
-};
-
 class Disassembler {
 public:
+  /**
+   * Receives the next batch of decoded lines and the number of bytes of
+   * the section decoded so far. Return false to cancel. Batches come in
+   * order and one at a time, but maybe from worker threads.
+   */
+  typedef std::function<bool(const Disassembly &batch, qint64 pos)> BatchFunc;
+
+  /**
+   * Receives a decoded instruction as an index into a small window of
+   * the disassembly, with offsets relative to the section. The window is
+   * reused for the next instructions. Return false to stop.
+   */
+  typedef std::function<bool(const Disassembly &window, int index)> VisitFunc;
+
   Disassembler(BinaryObjectPtr obj);
   ~Disassembler();
 
+  /**
+   * Report decoded lines in batches of the given size while
+   * disassembling instead of only in the result, which is then left
+   * empty.
+   */
+  void setBatchFunc(BatchFunc func, int size = 8192);
+
   bool disassemble(SectionPtr sec, Disassembly &result);
   bool disassemble(const QByteArray &data, Disassembly &result,
                    quint64 offset = 0);
   bool disassemble(const QString &data, Disassembly &result,
                    quint64 offset = 0);
 
+  /**
+   * Decode the section one instruction at a time on the calling thread
+   * and hand each to func, so memory use doesn't grow with the section
+   * and the consumer can stop at any point. Returns false if nothing
+   * could be decoded or func stopped.
+   */
+  bool visit(SectionPtr sec, VisitFunc func);
+
+  /**
+   * Render instruction index of the result as text into out. The
+   * buffer of out is reused so rendering many lines in a row doesn't
+   * allocate for each.
+   */
+  void render(const Disassembly &result, int index, QString &out) const;
+
+  // All lines of the result separated by newlines, like for exporting.
+  QString getText(const Disassembly &result) const;
+
 private:
+  static Asm *createAsm(BinaryObjectPtr obj);
+
+  /**
+   * Split the section at function starts into chunks of roughly equal
+   * size that can be decoded independently. Yields offsets into the
+   * section with the end of the section as the last one.
+   */
+  QList<quint32> splitSection(SectionPtr sec) const;
+
+  bool disassembleChunks(SectionPtr sec, const QList<quint32> &chunks,
+                         Disassembly &result);
+
+  BinaryObjectPtr obj;
   Asm *asm_;
+  BatchFunc batchFunc;
 };
 
 #endif // BMOD_DISASSEMBLER_H
@@ -0,0 +1,25 @@
+#include "DisassemblerThread.h"
+
+DisassemblerThread::DisassemblerThread(BinaryObjectPtr obj, SectionPtr sec,
+                                       QObject *parent)
+  : CancellableThread(parent), obj{obj}, success{false}
+{
+  qRegisterMetaType<Disassembly>();
+
+  // Decode a copy so the section can be edited meanwhile. The data is
+  // implicitly shared until then.
+  this->sec = SectionPtr(new Section(*sec));
+}
+
+void DisassemblerThread::run() {
+  qint64 size = sec->getDataSize();
+  Disassembler dis(obj);
+  dis.setBatchFunc([this, size](const Disassembly &result, qint64 pos) {
+      if (isCancelled()) return false;
+      emit batch(result, pos, size);
+      return true;
+    });
+
+  Disassembly result;
+  success = dis.disassemble(sec, result);
+}
@@ -0,0 +1,34 @@
+#ifndef BMOD_DISASSEMBLER_THREAD_H
+#define BMOD_DISASSEMBLER_THREAD_H
+
+#include "Disassembler.h"
+#include "../Section.h"
+#include "../BinaryObject.h"
+#include "../CancellableThread.h"
+
+/**
+ * Disassembles a section on a worker thread and emits the decoded
+ * lines in batches as they are produced.
+ */
+class DisassemblerThread : public CancellableThread {
+  Q_OBJECT
+
+public:
+  DisassemblerThread(BinaryObjectPtr obj, SectionPtr sec,
+                     QObject *parent = nullptr);
+
+  bool isSuccess() const { return success; }
+
+signals:
+  void batch(const Disassembly &batch, qint64 pos, qint64 size);
+
+protected:
+  void run();
+
+private:
+  BinaryObjectPtr obj;
+  SectionPtr sec;
+  bool success;
+};
+
+#endif // BMOD_DISASSEMBLER_THREAD_H
@@ -0,0 +1,55 @@
+#include "Disassembly.h"
+
+void Disassembly::reserve(int size) {
+  offsets.reserve(size);
+  lengths.reserve(size);
+  opcodes.reserve(size);
+  operands.reserve(size);
+}
+
+void Disassembly::clear() {
+  offsets.resize(0);
+  lengths.resize(0);
+  opcodes.resize(0);
+  operands.resize(0);
+}
+
+void Disassembly::append(quint32 offset, quint16 length, quint16 opcode,
+                         const Operands &ops) {
+  offsets << offset;
+  lengths << length;
+  opcodes << opcode;
+  operands << ops;
+}
+
+void Disassembly::append(const Disassembly &other, int i, quint32 shift) {
+  append(other.offsets[i] + shift, other.lengths[i], other.opcodes[i],
+         other.operands[i]);
+}
+
+void Disassembly::appendAll(const Disassembly &other, quint32 shift) {
+  if (isEmpty() && shift == 0) {
+    *this = other;
+    return;
+  }
+
+  int first = offsets.size();
+  offsets << other.offsets;
+  lengths << other.lengths;
+  opcodes << other.opcodes;
+  operands << other.operands;
+  if (shift != 0) {
+    quint32 *data = offsets.data();
+    for (int i = first; i < offsets.size(); i++) {
+      data[i] += shift;
+    }
+  }
+}
+
+void Disassembly::replace(int i, const Disassembly &other, int j,
+                          quint32 shift) {
+  offsets[i] = other.offsets[j] + shift;
+  lengths[i] = other.lengths[j];
+  opcodes[i] = other.opcodes[j];
+  operands[i] = other.operands[j];
+}
@@ -0,0 +1,65 @@
+#ifndef BMOD_DISASSEMBLY_H
+#define BMOD_DISASSEMBLY_H
+
+#include <QVector>
+#include <QMetaType>
+
+/**
+ * Decoded instructions kept as parallel arrays of offsets, lengths,
+ * opcode IDs and operand records. No text is stored; the Asm of the
+ * architecture renders a line when it is shown or exported, see
+ * Disassembler::render().
+ */
+class Disassembly {
+public:
+  /**
+   * Operands of an instruction as decoded. Addresses are resolved
+   * against the address of the section, and the fields are interpreted
+   * by the Asm that produced them.
+   */
+  struct Operands {
+    quint64 disp, imm;
+    quint8 srcReg, dstReg, scale, index, base;
+    quint8 srcRegType, dstRegType, dataType;
+    quint8 dispBytes, immBytes;
+    quint16 flags;
+  };
+
+  int size() const { return opcodes.size(); }
+  bool isEmpty() const { return opcodes.isEmpty(); }
+  void reserve(int size);
+
+  // Remove all instructions but keep the reserved capacity.
+  void clear();
+
+  // Offset of instruction i from the start of the decoded bytes.
+  quint32 getOffset(int i) const { return offsets[i]; }
+
+  // Number of bytes consumed by instruction i.
+  quint16 getLength(int i) const { return lengths[i]; }
+
+  quint16 getOpcode(int i) const { return opcodes[i]; }
+  const Operands &getOperands(int i) const { return operands[i]; }
+
+  void append(quint32 offset, quint16 length, quint16 opcode,
+              const Operands &ops);
+
+  // Append instruction i of other with its offset moved by shift.
+  void append(const Disassembly &other, int i, quint32 shift = 0);
+
+  // Append all of other with its offsets moved by shift.
+  void appendAll(const Disassembly &other, quint32 shift = 0);
+
+  // Replace instruction i with instruction j of other, with its offset
+  // moved by shift.
+  void replace(int i, const Disassembly &other, int j, quint32 shift = 0);
+
+private:
+  QVector<quint32> offsets;
+  QVector<quint16> lengths, opcodes;
+  QVector<Operands> operands;
+};
+
+Q_DECLARE_METATYPE(Disassembly)
+
+#endif // BMOD_DISASSEMBLY_H
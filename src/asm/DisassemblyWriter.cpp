@@ -0,0 +1,79 @@
+#include <QIODevice>
+#include <QTextStream>
+
+#include "../Util.h"
+#include "DisassemblyWriter.h"
+
+namespace {
+  // Instructions between progress reports.
+  const int progressInterval = 4096;
+}
+
+DisassemblyWriter::DisassemblyWriter(BinaryObjectPtr obj)
+  : obj{obj}, lines{0}
+{ }
+
+bool DisassemblyWriter::write(SectionPtr sec, QIODevice *device) {
+  error.clear();
+  lines = 0;
+
+  QTextStream out(device);
+  const auto &symTable = obj->getSymbolTable();
+  quint64 addr = sec->getAddress();
+  qint64 size = sec->getDataSize();
+  int addrLen = obj->getSystemBits() / 8;
+  bool filtered = !filter.isEmpty(), cancelled{false};
+  QString line, name;
+  qint64 count{0};
+
+  Disassembler dis(obj);
+  bool ok = dis.visit(sec, [&](const Disassembly &window, int i) {
+      quint32 offset = window.getOffset(i);
+      dis.render(window, i, line);
+      if (filtered) {
+        if (filter.indexIn(line) == -1) {
+          line.resize(0);
+        }
+      }
+      else if (symTable.getString(addr + offset, name)) {
+        out << (lines > 0 ? "\n" : "") << name << ":\n";
+        lines++;
+      }
+
+      if (!line.isEmpty()) {
+        // Refers to the section bytes without copying unless edited.
+        int len = window.getLength(i);
+        out << Util::padString(QString::number(addr + offset, 16).toUpper(),
+                               addrLen)
+            << '\t' << Util::dataToHex(sec->read(offset, len), 0, len)
+            << '\t' << line << '\n';
+        lines++;
+      }
+
+      if (++count % progressInterval == 0 && progressFunc &&
+          !progressFunc(offset, size)) {
+        cancelled = true;
+        return false;
+      }
+      return out.status() == QTextStream::Ok;
+    });
+
+  out.flush();
+  if (cancelled) {
+    error = QObject::tr("Cancelled.");
+    return false;
+  }
+  if (out.status() != QTextStream::Ok) {
+    error = QObject::tr("Could not write disassembly: %1")
+      .arg(device->errorString());
+    return false;
+  }
+  if (!ok && count == 0) {
+    error = QObject::tr("Could not disassemble machine code!");
+    return false;
+  }
+  if (progressFunc) {
+    progressFunc(size, size);
+  }
+  return true;
+}
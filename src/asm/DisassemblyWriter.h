@@ -0,0 +1,46 @@
+#ifndef BMOD_DISASSEMBLY_WRITER_H
+#define BMOD_DISASSEMBLY_WRITER_H
+
+#include <QString>
+#include <QRegExp>
+
+#include <functional>
+
+#include "Disassembler.h"
+#include "../Section.h"
+#include "../BinaryObject.h"
+
+class QIODevice;
+
+/**
+ * Writes the disassembly of a section as lines of address, machine code
+ * and instruction separated by tabs, with the names of functions as
+ * labels. Instructions are streamed with Disassembler::visit(), so the
+ * disassembly is never kept in memory as a whole.
+ */
+class DisassemblyWriter {
+public:
+  // Receives the number of bytes decoded so far. Return false to cancel.
+  typedef std::function<bool(qint64 pos, qint64 size)> ProgressFunc;
+
+  DisassemblyWriter(BinaryObjectPtr obj);
+
+  // Only write the instructions matching filter, and no labels.
+  void setFilter(const QRegExp &filter) { this->filter = filter; }
+
+  void setProgressFunc(ProgressFunc func) { progressFunc = func; }
+
+  bool write(SectionPtr sec, QIODevice *device);
+
+  const QString &getError() const { return error; }
+  qint64 getLineCount() const { return lines; }
+
+private:
+  BinaryObjectPtr obj;
+  QRegExp filter;
+  ProgressFunc progressFunc;
+  QString error;
+  qint64 lines;
+};
+
+#endif // BMOD_DISASSEMBLY_WRITER_H
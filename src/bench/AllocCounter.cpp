@@ -0,0 +1,77 @@
+#include <QtGlobal>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+#include "AllocCounter.h"
+
+namespace {
+  std::atomic<quint64> allocations{0};
+
+  inline void count() {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+#ifdef __GLIBC__
+// Wrap the allocator of the C library so allocations in shared
+// libraries are counted too.
+extern "C" {
+  void *__libc_malloc(size_t size);
+  void *__libc_calloc(size_t num, size_t size);
+  void *__libc_realloc(void *ptr, size_t size);
+
+  void *malloc(size_t size) {
+    count();
+    return __libc_malloc(size);
+  }
+
+  void *calloc(size_t num, size_t size) {
+    count();
+    return __libc_calloc(num, size);
+  }
+
+  void *realloc(void *ptr, size_t size) {
+    count();
+    return __libc_realloc(ptr, size);
+  }
+}
+#else
+void *operator new(std::size_t size) {
+  count();
+  void *ptr = std::malloc(size ? size : 1);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void *ptr) noexcept {
+  std::free(ptr);
+}
+#endif
+
+quint64 allocationCount() {
+  return allocations.load(std::memory_order_relaxed);
+}
+
+qint64 peakResidentSize() {
+#ifdef Q_OS_UNIX
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+#ifdef MAC
+  return usage.ru_maxrss;
+#else
+  return (qint64) usage.ru_maxrss * 1024;
+#endif
+#else
+  return 0;
+#endif
+}
@@ -0,0 +1,16 @@
+#ifndef BMOD_ALLOC_COUNTER_H
+#define BMOD_ALLOC_COUNTER_H
+
+#include <QtGlobal>
+
+/**
+ * Number of heap allocations made by the process so far. With glibc
+ * every malloc() is counted, including those of Qt, otherwise only
+ * operator new is.
+ */
+quint64 allocationCount();
+
+// Peak resident set size of the process in bytes, or 0 if unknown.
+qint64 peakResidentSize();
+
+#endif // BMOD_ALLOC_COUNTER_H
@@ -0,0 +1,353 @@
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include "SyntheticMachO.h"
+
+namespace {
+  // Common i386 function prologue/body/epilogue instructions.
+  const char *mix32[] = {
+    "55",                   // push %ebp
+    "89E5",                 // mov %esp, %ebp
+    "83EC18",               // sub $0x18, %esp
+    "8B4508",               // mov 0x8(%ebp), %eax
+    "8945FC",               // mov %eax, -0x4(%ebp)
+    "83C001",               // add $0x1, %eax
+    "3D00010000",           // cmp $0x100, %eax
+    "0F8405000000",         // je rel32
+    "E800000000",           // call rel32
+    "31C0",                 // xor %eax, %eax
+    "C745F800000000",       // movl $0x0, -0x8(%ebp)
+    "B801000000",           // mov $0x1, %eax
+    "85C0",                 // test %eax, %eax
+    "7502",                 // jne rel8
+    "EB00",                 // jmp rel8
+    "0FB645FF",             // movzbl -0x1(%ebp), %eax
+    "83C418",               // add $0x18, %esp
+    "5D",                   // pop %ebp
+    "C3",                   // ret
+    "0F1F440000"            // nopl 0x0(%eax,%eax,1)
+  };
+
+  // Common x86-64 function prologue/body/epilogue instructions.
+  const char *mix64[] = {
+    "55",                   // push %rbp
+    "4889E5",               // mov %rsp, %rbp
+    "4883EC20",             // sub $0x20, %rsp
+    "897DFC",               // mov %edi, -0x4(%rbp)
+    "488975F0",             // mov %rsi, -0x10(%rbp)
+    "8B45FC",               // mov -0x4(%rbp), %eax
+    "83C001",               // add $0x1, %eax
+    "3D00010000",           // cmp $0x100, %eax
+    "0F8405000000",         // je rel32
+    "E800000000",           // call rel32
+    "31C0",                 // xor %eax, %eax
+    "C745F800000000",       // movl $0x0, -0x8(%rbp)
+    "488D3D00000000",       // lea 0x0(%rip), %rdi
+    "B801000000",           // mov $0x1, %eax
+    "85C0",                 // test %eax, %eax
+    "7502",                 // jne rel8
+    "EB00",                 // jmp rel8
+    "0FB645FF",             // movzbl -0x1(%rbp), %eax
+    "4883C420",             // add $0x20, %rsp
+    "5D",                   // pop %rbp
+    "C3",                   // ret
+    "0F1F440000"            // nopl 0x0(%rax,%rax,1)
+  };
+
+  const char *verbs[] = {
+    "get", "set", "parse", "read", "write", "update", "find", "decode",
+    "init", "free"
+  };
+
+  const char *nouns[] = {
+    "Header", "Section", "Symbol", "String", "Buffer", "Table", "Entry",
+    "Object", "Region", "Page"
+  };
+
+  const char *formats[] = {
+    "Could not open %s: %s\n",
+    "usage: %s [options] file...\n",
+    "\t%-20s %08x\n",
+    "error: invalid %s at offset %d",
+    "com.example.%s.%d",
+    "%s: %llu bytes in %d regions\n",
+    "assertion failed: %s (%s:%d)",
+    "Loading %s.."
+  };
+
+  // Deterministic pseudo-random numbers.
+  class Random {
+  public:
+    quint32 next(quint32 max) {
+      seed = seed * 1103515245 + 12345;
+      return (seed >> 16) % max;
+    }
+
+  private:
+    quint32 seed{1};
+  };
+
+  template <typename T, int N>
+  int count(T (&)[N]) { return N; }
+
+  void putUInt32(QByteArray &out, quint32 value) {
+    for (int i = 0; i < 4; i++) {
+      out += char((value >> (i * 8)) & 0xFF);
+    }
+  }
+
+  void putUInt32BE(QByteArray &out, quint32 value) {
+    for (int i = 3; i >= 0; i--) {
+      out += char((value >> (i * 8)) & 0xFF);
+    }
+  }
+
+  void putUInt64(QByteArray &out, quint64 value) {
+    putUInt32(out, value & 0xFFFFFFFF);
+    putUInt32(out, value >> 32);
+  }
+
+  // Address or size field of a 32 or 64-bit header.
+  void putAddr(QByteArray &out, quint64 value, bool is64) {
+    if (is64) {
+      putUInt64(out, value);
+    }
+    else {
+      putUInt32(out, value);
+    }
+  }
+
+  void putName(QByteArray &out, const char *name) {
+    out += QByteArray(name).leftJustified(16, '\0', true);
+  }
+
+  void putULEB128(QByteArray &out, quint64 value) {
+    do {
+      unsigned char byte = value & 0x7F;
+      value >>= 7;
+      if (value != 0) byte |= 0x80;
+      out += char(byte);
+    } while (value != 0);
+  }
+
+  void pad(QByteArray &out, int alignment) {
+    while (out.size() % alignment != 0) {
+      out += '\0';
+    }
+  }
+
+  int aligned(int value, int alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+  }
+
+  QString symbolName(Random &rnd, int num) {
+    QString verb = verbs[rnd.next(count(verbs))],
+      noun = nouns[rnd.next(count(nouns))];
+
+    // Every third symbol is a mangled C++ method.
+    if (num % 3 == 0) {
+      QString cls = noun + "Reader", method = verb + noun;
+      return QString("__ZN4bmod%1%2%3%4Ev").arg(cls.size()).arg(cls)
+        .arg(method.size()).arg(method);
+    }
+    return QString("_%1_%2_%3").arg(verb).arg(noun.toLower()).arg(num);
+  }
+
+  QByteArray makeStrings(Random &rnd, int size) {
+    QByteArray data;
+    data.reserve(size + 64);
+    for (int num = 0; data.size() < size; num++) {
+      if (num % 2 == 0) {
+        data += formats[rnd.next(count(formats))];
+      }
+      else {
+        QStringList words;
+        int len = 1 + rnd.next(6);
+        for (int i = 0; i < len; i++) {
+          words << nouns[rnd.next(count(nouns))];
+        }
+        data += words.join(' ').toUtf8();
+      }
+      data += '\0';
+    }
+    return data;
+  }
+}
+
+QByteArray SyntheticMachO::generate(CpuType cpu, int textSize) {
+  bool is64 = (cpu == CpuType::X86_64);
+  Random rnd;
+
+  // Functions of one or more passes of the mix.
+  QByteArray mix = instructionMix(cpu), text;
+  QList<int> starts;
+  text.reserve(textSize + mix.size() * 6);
+  while (text.size() < textSize) {
+    starts << text.size();
+    int reps = 1 + rnd.next(6);
+    for (int i = 0; i < reps; i++) {
+      text += mix;
+    }
+  }
+
+  QByteArray cstrings = makeStrings(rnd, qMax(textSize / 8, 1));
+
+  QByteArray strtab(" ", 2), syms;
+  QList<quint32> strIndices;
+  for (int i = 0; i < starts.size(); i++) {
+    strIndices << strtab.size();
+    strtab += symbolName(rnd, i).toUtf8();
+    strtab += '\0';
+  }
+  pad(strtab, 8);
+
+  // Layout of the file.
+  int headerSize = (is64 ? 32 : 28),
+    segmentSize = (is64 ? 72 : 56),
+    sectionSize = (is64 ? 80 : 68),
+    nlistSize = (is64 ? 16 : 12),
+    cmdsSize = segmentSize + 2 * sectionSize + 24 + 16;
+  quint64 base = (is64 ? 0x100000000ULL : 0x1000);
+  int textOff = aligned(headerSize + cmdsSize, 16),
+    cstringOff = textOff + text.size(),
+    segmentEnd = cstringOff + cstrings.size();
+
+  QByteArray funcStarts;
+  int last{0};
+  foreach (int start, starts) {
+    // The first delta is relative to the start of the __TEXT segment.
+    putULEB128(funcStarts, (start + textOff) - last);
+    last = start + textOff;
+  }
+  funcStarts += '\0';
+  pad(funcStarts, 8);
+
+  int funcStartsOff = aligned(segmentEnd, 8),
+    symOff = funcStartsOff + funcStarts.size(),
+    strOff = symOff + starts.size() * nlistSize;
+
+  for (int i = 0; i < starts.size(); i++) {
+    putUInt32(syms, strIndices[i]);
+    syms += char(0x0F); // N_SECT | N_EXT
+    syms += char(1);    // __text
+    syms += char(0);
+    syms += char(0);
+    putAddr(syms, base + textOff + starts[i], is64);
+  }
+
+  QByteArray out;
+  out.reserve(strOff + strtab.size());
+
+  // Header.
+  putUInt32(out, is64 ? 0xFEEDFACF : 0xFEEDFACE);
+  putUInt32(out, is64 ? 7 + 0x01000000 : 7);
+  putUInt32(out, is64 ? 3 + 0x80000000 : 3);
+  putUInt32(out, 2); // MH_EXECUTE
+  putUInt32(out, 3);
+  putUInt32(out, cmdsSize);
+  putUInt32(out, 0x00200085); // NOUNDEFS | DYLDLINK | TWOLEVEL | PIE
+  if (is64) {
+    putUInt32(out, 0);
+  }
+
+  // LC_SEGMENT(_64) of __TEXT with __text and __cstring.
+  putUInt32(out, is64 ? 0x19 : 0x1);
+  putUInt32(out, segmentSize + 2 * sectionSize);
+  putName(out, "__TEXT");
+  putAddr(out, base, is64);
+  putAddr(out, aligned(segmentEnd, 4096), is64);
+  putAddr(out, 0, is64);
+  putAddr(out, segmentEnd, is64);
+  putUInt32(out, 7);
+  putUInt32(out, 5);
+  putUInt32(out, 2);
+  putUInt32(out, 0);
+
+  struct {
+    const char *name;
+    int offset, size, align;
+    quint32 flags;
+  } sections[] = {
+    {"__text", textOff, text.size(), 4, 0x80000400},
+    {"__cstring", cstringOff, cstrings.size(), 0, 0x2}
+  };
+  for (const auto &sec : sections) {
+    putName(out, sec.name);
+    putName(out, "__TEXT");
+    putAddr(out, base + sec.offset, is64);
+    putAddr(out, sec.size, is64);
+    putUInt32(out, sec.offset);
+    putUInt32(out, sec.align);
+    putUInt32(out, 0);
+    putUInt32(out, 0);
+    putUInt32(out, sec.flags);
+    putUInt32(out, 0);
+    putUInt32(out, 0);
+    if (is64) {
+      putUInt32(out, 0);
+    }
+  }
+
+  // LC_SYMTAB
+  putUInt32(out, 0x2);
+  putUInt32(out, 24);
+  putUInt32(out, symOff);
+  putUInt32(out, starts.size());
+  putUInt32(out, strOff);
+  putUInt32(out, strtab.size());
+
+  // LC_FUNCTION_STARTS
+  putUInt32(out, 0x26);
+  putUInt32(out, 16);
+  putUInt32(out, funcStartsOff);
+  putUInt32(out, funcStarts.size());
+
+  pad(out, 16);
+  out += text;
+  out += cstrings;
+  pad(out, 8);
+  out += funcStarts;
+  out += syms;
+  out += strtab;
+  return out;
+}
+
+QByteArray SyntheticMachO::generateFat(int textSize) {
+  QList<CpuType> cpus{CpuType::X86, CpuType::X86_64};
+  QList<QByteArray> slices;
+  foreach (auto cpu, cpus) {
+    slices << generate(cpu, textSize);
+  }
+
+  // Slices are page aligned.
+  QByteArray out;
+  putUInt32BE(out, 0xCAFEBABE);
+  putUInt32BE(out, slices.size());
+  int offset = aligned(8 + slices.size() * 20, 4096);
+  for (int i = 0; i < slices.size(); i++) {
+    putUInt32BE(out, cpus[i] == CpuType::X86_64 ? 7 + 0x01000000 : 7);
+    putUInt32BE(out, 3);
+    putUInt32BE(out, offset);
+    putUInt32BE(out, slices[i].size());
+    putUInt32BE(out, 12);
+    offset = aligned(offset + slices[i].size(), 4096);
+  }
+
+  foreach (const auto &slice, slices) {
+    pad(out, 4096);
+    out += slice;
+  }
+  return out;
+}
+
+QByteArray SyntheticMachO::instructionMix(CpuType cpu) {
+  QByteArray hex;
+  if (cpu == CpuType::X86_64) {
+    for (const char *inst : mix64) hex += inst;
+  }
+  else {
+    for (const char *inst : mix32) hex += inst;
+  }
+  return QByteArray::fromHex(hex);
+}
@@ -0,0 +1,27 @@
+#ifndef BMOD_SYNTHETIC_MACHO_H
+#define BMOD_SYNTHETIC_MACHO_H
+
+#include <QByteArray>
+
+#include "../CpuType.h"
+
+/**
+ * Generates Mach-O executables for benchmarking. The __text section is
+ * made of functions built from a common x86 or x86-64 instruction mix,
+ * each with a symbol and a function start, and __cstring holds strings
+ * like those of a typical program. Output is deterministic for a given
+ * size.
+ */
+class SyntheticMachO {
+public:
+  // Thin executable for cpu (X86 or X86_64) with textSize bytes of code.
+  static QByteArray generate(CpuType cpu, int textSize);
+
+  // Universal binary with an i386 and an x86-64 slice.
+  static QByteArray generateFat(int textSize);
+
+  // One pass of the instruction mix of cpu.
+  static QByteArray instructionMix(CpuType cpu);
+};
+
+#endif // BMOD_SYNTHETIC_MACHO_H
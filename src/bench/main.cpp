@@ -0,0 +1,492 @@
+/**
+ * Parsing and disassembly benchmark suite.
+ *
+ * Generates synthetic 32-bit, 64-bit and universal Mach-O binaries (or
+ * uses the files given) and measures parsing, disassembly, rendering
+ * of the lines, symbol lookups and the work the panes do on setup
+ * separately. Each result reports MB/s, items/s, heap allocations per
+ * iteration and the peak RSS of the process so far, and can be written
+ * as JSON to track regressions across versions. With --min-mbps the
+ * exit code is non-zero if the disassembly throughput drops below the
+ * threshold. With --verify only the vectorized formatting of bytes is
+ * checked against the byte-wise path.
+ */
+
+#include <QDir>
+#include <QFile>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QVector>
+#include <QFileInfo>
+#include <QByteArray>
+#include <QJsonArray>
+#include <QTextStream>
+#include <QJsonObject>
+#include <QEventLoop>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QTemporaryDir>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+
+#include "../Util.h"
+#include "../Version.h"
+#include "../Section.h"
+#include "../BinaryObject.h"
+#include "../StringScanner.h"
+#include "../formats/Format.h"
+#include "../asm/Disassembler.h"
+#include "../asm/DisassemblerThread.h"
+#include "../widgets/StringsModel.h"
+#include "../widgets/DisassemblyModel.h"
+#include "../widgets/MachineCodeModel.h"
+
+#include "AllocCounter.h"
+#include "SyntheticMachO.h"
+
+namespace {
+  struct Result {
+    QString name, input, unit;
+    int iterations;
+    qint64 bytes, items, nsecs, peakRss;
+    quint64 allocations;
+
+    double getSeconds() const { return double(nsecs) / 1e9; }
+
+    double getMbps() const {
+      double secs = getSeconds();
+      return secs > 0 ? double(bytes) / (1024.0 * 1024.0) / secs : 0;
+    }
+
+    double getItemsPerSec() const {
+      double secs = getSeconds();
+      return secs > 0 ? double(items) / secs : 0;
+    }
+
+    QJsonObject toJson() const {
+      QJsonObject obj;
+      obj["benchmark"] = name;
+      obj["input"] = input;
+      obj["iterations"] = iterations;
+      obj["seconds"] = getSeconds();
+      obj["bytes"] = double(bytes);
+      obj["mbps"] = getMbps();
+      obj["items"] = double(items);
+      obj["unit"] = unit;
+      obj["itemsPerSecond"] = getItemsPerSec();
+      obj["allocationsPerIteration"] = double(allocations);
+      obj["peakRssBytes"] = double(peakRss);
+      return obj;
+    }
+  };
+
+  /**
+   * Run func the number of iterations and collect the elapsed time and
+   * allocations. func adds the bytes and items it processed.
+   */
+  template <typename Func>
+  Result measure(const QString &name, const QString &input,
+                 const QString &unit, int iterations, Func func) {
+    Result res{name, input, unit, iterations, 0, 0, 0, 0, 0};
+    quint64 allocs = allocationCount();
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; i++) {
+      func(res.bytes, res.items);
+    }
+    res.nsecs = timer.nsecsElapsed();
+    res.allocations = (allocationCount() - allocs) / iterations;
+    res.peakRss = peakResidentSize();
+    return res;
+  }
+
+  struct Options {
+    int iterations;
+    QStringList benchmarks;
+  };
+
+  void benchParse(const QString &file, const QString &input,
+                  const Options &opts, QList<Result> &results) {
+    qint64 size = QFileInfo(file).size();
+    results << measure("parse", input, "symbols", opts.iterations,
+                       [&](qint64 &bytes, qint64 &items) {
+        auto fmt = Format::detect(file);
+        if (fmt && fmt->parse()) {
+          bytes += size;
+          foreach (const auto obj, fmt->getObjects()) {
+            items += obj->getSymbolTable().getSymbols().size();
+          }
+        }
+      });
+  }
+
+  void benchDisassemble(BinaryObjectPtr obj, SectionPtr text,
+                        const QString &input, const Options &opts,
+                        QList<Result> &results) {
+    results << measure("disassemble", input, "instructions", opts.iterations,
+                       [&](qint64 &bytes, qint64 &items) {
+        Disassembler dis(obj);
+        Disassembly result;
+        dis.disassemble(text, result);
+        bytes += text->getDataSize();
+        items += result.size();
+      });
+  }
+
+  void benchRender(BinaryObjectPtr obj, SectionPtr text, const QString &input,
+                   const Options &opts, QList<Result> &results) {
+    Disassembler dis(obj);
+    Disassembly result;
+    dis.disassemble(text, result);
+    results << measure("render", input, "lines", opts.iterations,
+                       [&](qint64 &bytes, qint64 &items) {
+        QString str = dis.getText(result);
+        bytes += str.size() * sizeof(QChar);
+        items += result.size();
+      });
+  }
+
+  void benchSymbols(BinaryObjectPtr obj, SectionPtr text,
+                    const QString &input, const Options &opts,
+                    QList<Result> &results) {
+    const auto &symTable = obj->getSymbolTable();
+    quint64 addr = text->getAddress(), size = text->getDataSize();
+    if (size == 0) return;
+    int lookups = qBound<quint64>(1, size / 16, 1000000);
+    results << measure("symbols", input, "lookups", opts.iterations,
+                       [&](qint64 &bytes, qint64 &items) {
+        QString name;
+        quint64 start;
+        for (int i = 0; i < lookups; i++) {
+          // Spread the lookups over the section like scrolling does.
+          quint64 value = addr + ((quint64) i * 7919 * 16) % size;
+          if (symTable.getEnclosingString(value, name, &start)) {
+            symTable.getString(start, name);
+          }
+        }
+        bytes += size;
+        items += lookups;
+      });
+  }
+
+  // Ask the model for the text of all columns of the rows, like
+  // scrolling through the whole view would.
+  void renderRows(const QAbstractItemModel &model, qint64 &items) {
+    int rows = model.rowCount(), cols = model.columnCount();
+    for (int row = 0; row < rows; row++) {
+      for (int col = 0; col < cols; col++) {
+        model.data(model.index(row, col));
+      }
+    }
+    items += rows;
+  }
+
+  /**
+   * Work of the panes without the widgets, through the models they
+   * use: disassembling into the rows of the disassembly on a worker
+   * thread, formatting all rows of the machine code, and finding and
+   * formatting all strings.
+   */
+  void benchPanes(BinaryObjectPtr obj, SectionPtr text, SectionPtr cstrings,
+                  const QString &input, const Options &opts,
+                  QList<Result> &results) {
+    if (text && opts.benchmarks.contains("disassembly-pane")) {
+      results << measure("disassembly-pane", input, "instructions",
+                         opts.iterations, [&](qint64 &bytes, qint64 &items) {
+          DisassemblyModel model(obj, text);
+          DisassemblerThread thread(obj, text);
+          QObject::connect(&thread, &DisassemblerThread::batch, &model,
+                           [&model](const Disassembly &batch, qint64,
+                                    qint64) {
+                             model.appendDisassembly(batch);
+                           });
+          QEventLoop loop;
+          QObject::connect(&thread, &QThread::finished,
+                           &loop, &QEventLoop::quit);
+          thread.start();
+          loop.exec();
+          thread.wait();
+          bytes += text->getDataSize();
+          items += model.getInstructionCount();
+        });
+    }
+
+    if (text && opts.benchmarks.contains("machine-code-pane")) {
+      results << measure("machine-code-pane", input, "rows", opts.iterations,
+                         [&](qint64 &bytes, qint64 &items) {
+          MachineCodeModel model(obj, text);
+          renderRows(model, items);
+          bytes += text->getDataSize();
+        });
+    }
+
+    if (cstrings && opts.benchmarks.contains("strings-pane")) {
+      results << measure("strings-pane", input, "strings", opts.iterations,
+                         [&](qint64 &bytes, qint64 &items) {
+          StringsModel model(obj, cstrings);
+          int size = cstrings->getDataSize();
+          model.setSpans(StringScanner::split(cstrings->read(0, size)), true);
+          renderRows(model, items);
+          bytes += size;
+        });
+    }
+  }
+
+  bool benchFile(const QString &file, const QString &input,
+                 const Options &opts, QList<Result> &results) {
+    if (opts.benchmarks.contains("parse")) {
+      benchParse(file, input, opts, results);
+    }
+
+    auto fmt = Format::detect(file);
+    if (fmt == nullptr || !fmt->parse()) {
+      return false;
+    }
+
+    const auto objects = fmt->getObjects();
+    foreach (const auto obj, objects) {
+      if (obj->getCpuType() != CpuType::X86 &&
+          obj->getCpuType() != CpuType::X86_64) {
+        continue;
+      }
+
+      QString name = input;
+      if (objects.size() > 1) {
+        name += "/" + Util::cpuTypeString(obj->getCpuType());
+      }
+
+      auto text = obj->getSection(SectionType::Text);
+      if (text && opts.benchmarks.contains("disassemble")) {
+        benchDisassemble(obj, text, name, opts, results);
+      }
+      if (text && opts.benchmarks.contains("render")) {
+        benchRender(obj, text, name, opts, results);
+      }
+      if (text && opts.benchmarks.contains("symbols")) {
+        benchSymbols(obj, text, name, opts, results);
+      }
+      benchPanes(obj, text, obj->getSection(SectionType::CString), name, opts,
+                 results);
+    }
+    return true;
+  }
+
+  /**
+   * Compare the 16 bytes at a time path of the hex and ASCII formatting
+   * with formatting one byte at a time, which only uses the byte-wise
+   * path. Every rotation of all 256 byte values is formatted at lengths
+   * that aren't a multiple of 16, so each value goes through both the
+   * vectorized part and the remainder.
+   */
+  bool verifyFormatting(QTextStream &err) {
+    QByteArray data(256 + 15, 0);
+    QString hex(2 * data.size(), Qt::Uninitialized),
+      ascii(data.size(), Qt::Uninitialized), hexRef(hex), asciiRef(ascii);
+    for (int rot = 0; rot < 256; rot++) {
+      for (int i = 0; i < data.size(); i++) {
+        data[i] = char((i + rot) & 0xFF);
+      }
+      for (int len = 257; len <= data.size(); len++) {
+        const char *ptr = data.constData();
+        Util::formatHex(ptr, len, hex.data());
+        Util::formatAscii(ptr, len, ascii.data());
+        for (int i = 0; i < len; i++) {
+          Util::formatHex(ptr + i, 1, hexRef.data() + 2 * i);
+          Util::formatAscii(ptr + i, 1, asciiRef.data() + i);
+        }
+        if (hex.left(2 * len) != hexRef.left(2 * len)) {
+          err << "formatHex differs at rotation " << rot << ", length "
+              << len << endl;
+          return false;
+        }
+        if (ascii.left(len) != asciiRef.left(len)) {
+          err << "formatAscii differs at rotation " << rot << ", length "
+              << len << endl;
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  bool writeFile(const QString &file, const QByteArray &data) {
+    QFile f(file);
+    return f.open(QIODevice::WriteOnly) && f.write(data) == data.size();
+  }
+}
+
+int main(int argc, char **argv) {
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName("bmod-bench");
+  QCoreApplication::setApplicationVersion(versionString());
+
+  const QStringList allBenchmarks{"parse", "disassemble", "render", "symbols",
+      "disassembly-pane", "machine-code-pane", "strings-pane"};
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Parsing and disassembly benchmarks.");
+  parser.addHelpOption();
+  parser.addVersionOption();
+  parser.addPositionalArgument("files", "Mach-O binaries to benchmark "
+                               "instead of the synthetic ones.", "[files...]");
+
+  QCommandLineOption iterOpt("iterations", "Number of passes per benchmark.",
+                             "n", "10");
+  parser.addOption(iterOpt);
+
+  QCommandLineOption sizeOpt("size",
+                             "Size in MB of the code of each synthetic "
+                             "binary or slice.", "mb", "16");
+  parser.addOption(sizeOpt);
+
+  QCommandLineOption corpusOpt("corpus",
+                               "Synthetic binaries to generate, separated by "
+                               "commas: i386, x86_64 and fat.", "names",
+                               "i386,x86_64,fat");
+  parser.addOption(corpusOpt);
+
+  QCommandLineOption corpusDirOpt("corpus-dir",
+                                  "Keep the synthetic binaries in dir.",
+                                  "dir");
+  parser.addOption(corpusDirOpt);
+
+  QCommandLineOption benchOpt("benchmarks",
+                              "Benchmarks to run, separated by commas: " +
+                              allBenchmarks.join(", ") + ".", "names",
+                              allBenchmarks.join(','));
+  parser.addOption(benchOpt);
+
+  QCommandLineOption jsonOpt("json",
+                             "Write the results as JSON to file, or to "
+                             "standard output if file is -.", "file");
+  parser.addOption(jsonOpt);
+
+  QCommandLineOption minOpt("min-mbps",
+                            "Fail if disassembly throughput is below this "
+                            "many MB/s.", "mbps", "0");
+  parser.addOption(minOpt);
+
+  QCommandLineOption verifyOpt("verify",
+                               "Only check the vectorized formatting of "
+                               "bytes against the byte-wise path.");
+  parser.addOption(verifyOpt);
+
+  parser.process(app);
+
+  QTextStream out(stdout), err(stderr);
+
+  if (parser.isSet(verifyOpt)) {
+    if (!verifyFormatting(err)) {
+      return 1;
+    }
+    out << "Formatting verified." << endl;
+    return 0;
+  }
+
+  Options opts;
+  opts.iterations = qMax(parser.value(iterOpt).toInt(), 1);
+  opts.benchmarks = parser.value(benchOpt).split(',', QString::SkipEmptyParts);
+  foreach (const auto &name, opts.benchmarks) {
+    if (!allBenchmarks.contains(name)) {
+      err << "Unknown benchmark: " << name << endl;
+      return 1;
+    }
+  }
+  double minMbps = parser.value(minOpt).toDouble();
+
+  // Inputs as pairs of name and file.
+  QList<QPair<QString, QString>> inputs;
+  QTemporaryDir tmpDir;
+  const QStringList args = parser.positionalArguments();
+  if (!args.isEmpty()) {
+    foreach (const auto &file, args) {
+      inputs << qMakePair(QFileInfo(file).fileName(), file);
+    }
+  }
+  else {
+    QString dir = tmpDir.path();
+    if (parser.isSet(corpusDirOpt)) {
+      dir = parser.value(corpusDirOpt);
+      QDir().mkpath(dir);
+    }
+
+    int size = qMax(parser.value(sizeOpt).toInt(), 1) * 1024 * 1024;
+    foreach (const auto &name,
+             parser.value(corpusOpt).split(',', QString::SkipEmptyParts)) {
+      QByteArray data;
+      if (name == "i386") {
+        data = SyntheticMachO::generate(CpuType::X86, size);
+      }
+      else if (name == "x86_64") {
+        data = SyntheticMachO::generate(CpuType::X86_64, size);
+      }
+      else if (name == "fat") {
+        data = SyntheticMachO::generateFat(size);
+      }
+      else {
+        err << "Unknown synthetic binary: " << name << endl;
+        return 1;
+      }
+
+      QString file = QDir(dir).absoluteFilePath("synthetic-" + name);
+      if (!writeFile(file, data)) {
+        err << "Could not write: " << file << endl;
+        return 1;
+      }
+      inputs << qMakePair(name, file);
+    }
+  }
+
+  QList<Result> results;
+  foreach (const auto &input, inputs) {
+    if (!benchFile(input.second, input.first, opts, results)) {
+      err << "Could not parse file: " << input.second << endl;
+      return 1;
+    }
+  }
+
+  QString jsonFile = parser.value(jsonOpt);
+  if (jsonFile != "-") {
+    foreach (const auto &res, results) {
+      out << res.input.leftJustified(16) << " "
+          << res.name.leftJustified(18) << " "
+          << QString::number(res.getMbps(), 'f', 2) << " MB/s, "
+          << QString::number(res.getItemsPerSec(), 'f', 0) << " "
+          << res.unit << "/s, " << res.allocations << " allocs/iter, "
+          << Util::formatSize(res.peakRss) << " peak RSS" << endl;
+    }
+  }
+
+  if (!jsonFile.isEmpty()) {
+    QJsonArray array;
+    foreach (const auto &res, results) {
+      array << res.toJson();
+    }
+    QJsonObject root;
+    root["program"] = QString("bmod-bench");
+    root["version"] = versionString();
+    root["iterations"] = opts.iterations;
+    root["peakRssBytes"] = double(peakResidentSize());
+    root["results"] = array;
+    QByteArray json = QJsonDocument(root).toJson();
+    if (jsonFile == "-") {
+      out << json;
+    }
+    else if (!writeFile(jsonFile, json)) {
+      err << "Could not write: " << jsonFile << endl;
+      return 1;
+    }
+  }
+
+  if (minMbps > 0) {
+    foreach (const auto &res, results) {
+      if (res.name == "disassemble" && res.getMbps() < minMbps) {
+        err << res.input << ": disassembly throughput below minimum of "
+            << minMbps << " MB/s!" << endl;
+        return 2;
+      }
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,120 @@
+#include <QStringList>
+
+#include "../Util.h"
+#include "PatchSpec.h"
+
+namespace {
+  bool parseHex(QString str, QByteArray &data) {
+    str.remove(' ');
+    if (str.size() % 2 != 0) return false;
+    data = Util::hexToData(str);
+    return data.size() * 2 == str.size();
+  }
+
+  QString formatAddress(quint64 addr) {
+    return "0x" + QString::number(addr, 16);
+  }
+}
+
+bool PatchSpec::parse(const QString &str, PatchSpec &spec, QString *error) {
+  auto fail = [error](const QString &msg) {
+    if (error) *error = msg;
+    return false;
+  };
+
+  QStringList parts = str.split(':');
+  if (parts.size() != 3) {
+    return fail(QObject::tr("Expected target:expected:bytes"));
+  }
+
+  spec = PatchSpec();
+  spec.str = str;
+  spec.addr = spec.offset = 0;
+
+  QString target = parts[0].trimmed();
+  bool ok{true};
+  if (target.startsWith("0x", Qt::CaseInsensitive)) {
+    spec.addr = target.mid(2).toULongLong(&ok, 16);
+  }
+  else {
+    int plus = target.indexOf('+');
+    spec.symbol = target.left(plus).trimmed();
+    if (plus != -1) {
+      spec.offset = target.mid(plus + 1).trimmed().toULongLong(&ok, 0);
+    }
+    ok = ok && !spec.symbol.isEmpty();
+  }
+  if (!ok) {
+    return fail(QObject::tr("Invalid target: %1").arg(target));
+  }
+
+  if (!parseHex(parts[1], spec.expected)) {
+    return fail(QObject::tr("Invalid expected bytes: %1").arg(parts[1]));
+  }
+  if (!parseHex(parts[2], spec.data) || spec.data.isEmpty()) {
+    return fail(QObject::tr("Invalid bytes: %1").arg(parts[2]));
+  }
+  return true;
+}
+
+bool PatchSpec::resolve(BinaryObjectPtr obj, SectionPtr &sec, int &pos) const {
+  quint64 target = addr;
+  if (!symbol.isEmpty()) {
+    // C symbols are prefixed with an underscore in Mach-O.
+    quint64 value;
+    if (!obj->getSymbolTable().getValue(symbol, value) &&
+        !obj->getSymbolTable().getValue("_" + symbol, value)) {
+      return false;
+    }
+    target = value + offset;
+  }
+
+  // Only these sections are located by virtual address.
+  foreach (const auto s, obj->getSections()) {
+    auto type = s->getType();
+    if (type != SectionType::Text && type != SectionType::SymbolStubs &&
+        type != SectionType::CString) {
+      continue;
+    }
+    if (target >= s->getAddress() && target < s->getAddress() + s->getSize()) {
+      sec = s;
+      pos = target - s->getAddress();
+      return true;
+    }
+  }
+  return false;
+}
+
+bool PatchSpec::apply(BinaryObjectPtr obj, bool &found, QString *error) const {
+  SectionPtr sec;
+  int pos;
+  found = resolve(obj, sec, pos);
+  if (!found) {
+    return true;
+  }
+
+  quint64 target = sec->getAddress() + pos;
+  int len = qMax(data.size(), expected.size());
+  if (sec->read(pos, len).size() != len) {
+    if (error) {
+      *error = QObject::tr("%1: %2 runs past the end of the section")
+        .arg(str).arg(formatAddress(target));
+    }
+    return false;
+  }
+
+  if (!expected.isEmpty()) {
+    QByteArray cur = sec->read(pos, expected.size());
+    if (cur != expected) {
+      if (error) {
+        *error = QObject::tr("%1: expected %2 but found %3 at %4")
+          .arg(str).arg(Util::dataToHex(expected, 0, expected.size()))
+          .arg(Util::dataToHex(cur, 0, cur.size())).arg(formatAddress(target));
+      }
+      return false;
+    }
+  }
+
+  sec->setSubData(data, pos);
+  return true;
+}
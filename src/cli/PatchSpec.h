@@ -0,0 +1,45 @@
+#ifndef BMOD_PATCH_SPEC_H
+#define BMOD_PATCH_SPEC_H
+
+#include <QString>
+#include <QByteArray>
+
+#include "../Section.h"
+#include "../BinaryObject.h"
+
+/**
+ * Patch given on the command line as "target:expected:bytes".
+ *
+ * The target is a hex address like "0x100000f20" or a symbol name with
+ * an optional offset like "_main+0x10". Expected are the bytes that
+ * must be there before patching, or empty to not check, and bytes are
+ * the new bytes. Bytes are written in hex and may contain spaces.
+ */
+class PatchSpec {
+public:
+  static bool parse(const QString &str, PatchSpec &spec,
+                    QString *error = nullptr);
+
+  QString toString() const { return str; }
+
+  /**
+   * Find the section and position in it of the target in the object.
+   * Returns false if the object doesn't have the target.
+   */
+  bool resolve(BinaryObjectPtr obj, SectionPtr &sec, int &pos) const;
+
+  /**
+   * Check the expected bytes and write the new bytes at the target in
+   * the object. Returns false with the reason in error if the target
+   * was found but the patch could not be applied, and sets found
+   * whether the target was found.
+   */
+  bool apply(BinaryObjectPtr obj, bool &found, QString *error = nullptr) const;
+
+private:
+  QString str, symbol;
+  quint64 addr, offset;
+  QByteArray expected, data;
+};
+
+#endif // BMOD_PATCH_SPEC_H
@@ -0,0 +1,343 @@
+/**
+ * Headless batch patcher.
+ *
+ * Applies the same patches to a list of binaries without the GUI. Each
+ * patch names a target address or symbol, the bytes expected there and
+ * the new bytes, and a file is only written if all of its patches
+ * apply. Files are processed in parallel and the exit code is non-zero
+ * if any of them failed.
+ *
+ * With --disassemble the code of the binaries is written to standard
+ * output instead, optionally only the instructions matching --match.
+ * With --scan the binaries are searched for the byte signatures of a
+ * file, and a line is written for each hit.
+ */
+
+#include <QFile>
+#include <QList>
+#include <QRegExp>
+#include <QString>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+
+#include <vector>
+
+#include "PatchSpec.h"
+#include "../Util.h"
+#include "../Backup.h"
+#include "../Version.h"
+#include "../Parallel.h"
+#include "../CommitWriter.h"
+#include "../SignatureScanner.h"
+#include "../formats/Format.h"
+#include "../asm/DisassemblyWriter.h"
+
+namespace {
+  struct Options {
+    QList<PatchSpec> specs;
+    bool dryRun, backup;
+  };
+
+  struct Result {
+    bool ok;
+    QString message;
+  };
+
+  Result patchFile(const QString &file, const Options &opts) {
+    auto fmt = Format::detect(file);
+    if (fmt == nullptr) {
+      return Result{false, QObject::tr("unknown format")};
+    }
+    if (!fmt->parse()) {
+      return Result{false, QObject::tr("could not parse")};
+    }
+
+    // Universal binaries get the patch in every slice that has the target.
+    const auto objects = fmt->getObjects();
+    int applied{0};
+    foreach (const auto &spec, opts.specs) {
+      bool any{false};
+      foreach (const auto obj, objects) {
+        bool found;
+        QString error;
+        if (!spec.apply(obj, found, &error)) {
+          return Result{false, error};
+        }
+        if (found) {
+          any = true;
+          applied++;
+        }
+      }
+      if (!any) {
+        return Result{false, QObject::tr("%1: target not found")
+            .arg(spec.toString())};
+      }
+    }
+
+    if (opts.dryRun) {
+      return Result{true, QObject::tr("%1 patches verified").arg(applied)};
+    }
+
+    QString error;
+    if (opts.backup &&
+        !Backup::saveDelta(file, objects, Backup::nextFileName(file), &error)) {
+      return Result{false, error};
+    }
+
+    CommitWriter writer(file);
+    foreach (const auto obj, objects) {
+      writer.addObject(obj);
+    }
+    if (!writer.commit()) {
+      return Result{false, writer.getError()};
+    }
+    return Result{true, QObject::tr("%1 patches, %2 bytes in %3 regions")
+        .arg(applied).arg(writer.getBytesWritten())
+        .arg(writer.getRegionCount())};
+  }
+
+  bool disassembleFile(const QString &file, const QRegExp &filter,
+                       QFile &out, QTextStream &err) {
+    auto fmt = Format::detect(file);
+    if (fmt == nullptr || !fmt->parse()) {
+      err << file << ": could not parse" << endl;
+      return false;
+    }
+
+    bool ok{true};
+    const auto objects = fmt->getObjects();
+    foreach (const auto obj, objects) {
+      auto sec = obj->getSection(SectionType::Text);
+      if (!sec || (obj->getCpuType() != CpuType::X86 &&
+                   obj->getCpuType() != CpuType::X86_64)) {
+        continue;
+      }
+
+      QString header = file;
+      if (objects.size() > 1) {
+        header += " (" + Util::cpuTypeString(obj->getCpuType()) + ")";
+      }
+      out.write(QString("%1:\n").arg(header).toUtf8());
+
+      DisassemblyWriter writer(obj);
+      writer.setFilter(filter);
+      if (!writer.write(sec, &out)) {
+        err << file << ": " << writer.getError() << endl;
+        ok = false;
+      }
+      out.write("\n");
+    }
+    return ok;
+  }
+
+  Result scanFile(const QString &file, const SignatureScanner &scanner,
+                  QStringList &lines) {
+    auto fmt = Format::detect(file);
+    if (fmt == nullptr || !fmt->parse()) {
+      return Result{false, QObject::tr("could not parse")};
+    }
+
+    // The slices of universal binaries are scanned in parallel.
+    const auto hits = scanner.scan(fmt->getObjects());
+    foreach (const auto &hit, hits) {
+      quint64 addr = hit.section->getAddress() + hit.offset;
+      lines << QString("%1\t%2\t%3\t0x%4\t%5").arg(file)
+        .arg(Util::cpuTypeString(hit.object->getCpuType()))
+        .arg(hit.section->getName()).arg(addr, 0, 16)
+        .arg(scanner.getName(hit.signature));
+    }
+    return Result{true, QObject::tr("%1 hits").arg(hits.size())};
+  }
+
+  bool readSpecs(const QString &file, QStringList &specs) {
+    QFile f(file);
+    if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) {
+      return false;
+    }
+    QTextStream in(&f);
+    while (!in.atEnd()) {
+      QString line = in.readLine().trimmed();
+      if (!line.isEmpty() && !line.startsWith('#')) {
+        specs << line;
+      }
+    }
+    return true;
+  }
+}
+
+int main(int argc, char **argv) {
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName("bmod-cli");
+  QCoreApplication::setApplicationVersion(versionString());
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Headless batch patcher of binaries.");
+  parser.addHelpOption();
+  parser.addVersionOption();
+  parser.addPositionalArgument("files", "Binaries to patch.", "files...");
+
+  QCommandLineOption patchOpt(QStringList{"p", "patch"},
+                              "Patch of the form target:expected:bytes, where "
+                              "target is a hex address (0x..) or a symbol "
+                              "with an optional +offset, and expected and "
+                              "bytes are hex. Empty expected bytes are not "
+                              "checked. Can be given multiple times.",
+                              "spec");
+  parser.addOption(patchOpt);
+
+  QCommandLineOption patchFileOpt("patches",
+                                  "File with one patch per line. Lines "
+                                  "starting with # are ignored.", "file");
+  parser.addOption(patchFileOpt);
+
+  QCommandLineOption dryOpt(QStringList{"n", "dry-run"},
+                            "Only check that the patches apply.");
+  parser.addOption(dryOpt);
+
+  QCommandLineOption backupOpt(QStringList{"b", "backup"},
+                               "Save a delta backup of each file before "
+                               "writing it.");
+  parser.addOption(backupOpt);
+
+  QCommandLineOption jobsOpt(QStringList{"j", "jobs"},
+                             "Number of files to process at once.", "n", "0");
+  parser.addOption(jobsOpt);
+
+  QCommandLineOption quietOpt(QStringList{"q", "quiet"},
+                              "Only report failures.");
+  parser.addOption(quietOpt);
+
+  QCommandLineOption disOpt(QStringList{"d", "disassemble"},
+                            "Write the disassembly of the code of the files "
+                            "to standard output instead of patching.");
+  parser.addOption(disOpt);
+
+  QCommandLineOption matchOpt("match",
+                              "Only write the instructions matching the "
+                              "regular expression when disassembling.",
+                              "regexp");
+  parser.addOption(matchOpt);
+
+  QCommandLineOption scanOpt(QStringList{"s", "scan"},
+                             "Write the hits of the signatures of the file "
+                             "in the files to standard output instead of "
+                             "patching. Each line of it is name = bytes, "
+                             "where bytes are hex and ?? matches any byte.",
+                             "file");
+  parser.addOption(scanOpt);
+
+  parser.process(app);
+
+  QTextStream out(stdout), err(stderr);
+
+  if (parser.isSet(disOpt)) {
+    const QStringList files = parser.positionalArguments();
+    if (files.isEmpty()) {
+      parser.showHelp(1);
+    }
+
+    QRegExp filter(parser.value(matchOpt));
+    if (!filter.isValid()) {
+      err << "Invalid regular expression: " << filter.pattern() << endl;
+      return 1;
+    }
+
+    QFile stdOut;
+    stdOut.open(stdout, QIODevice::WriteOnly);
+    int failed{0};
+    foreach (const auto &file, files) {
+      if (!disassembleFile(file, filter, stdOut, err)) {
+        failed++;
+      }
+    }
+    return failed > 0 ? 2 : 0;
+  }
+
+  if (parser.isSet(scanOpt)) {
+    const QStringList files = parser.positionalArguments();
+    if (files.isEmpty()) {
+      parser.showHelp(1);
+    }
+
+    SignatureScanner scanner;
+    QString error;
+    if (!scanner.load(parser.value(scanOpt), &error)) {
+      err << "Invalid signatures: " << error << endl;
+      return 1;
+    }
+
+    std::vector<Result> results(files.size());
+    std::vector<QStringList> lines(files.size());
+    Parallel::run(files.size(), [&](int i) {
+        results[i] = scanFile(files[i], scanner, lines[i]);
+      }, parser.value(jobsOpt).toInt());
+
+    int failed{0};
+    for (int i = 0; i < files.size(); i++) {
+      if (!results[i].ok) {
+        failed++;
+        err << files[i] << ": " << results[i].message << endl;
+        continue;
+      }
+      foreach (const auto &line, lines[i]) {
+        out << line << endl;
+      }
+    }
+    return failed > 0 ? 2 : 0;
+  }
+
+  QStringList specStrs = parser.values(patchOpt);
+  if (parser.isSet(patchFileOpt) &&
+      !readSpecs(parser.value(patchFileOpt), specStrs)) {
+    err << "Could not read patches: " << parser.value(patchFileOpt) << endl;
+    return 1;
+  }
+
+  Options opts;
+  foreach (const auto &str, specStrs) {
+    PatchSpec spec;
+    QString error;
+    if (!PatchSpec::parse(str, spec, &error)) {
+      err << "Invalid patch \"" << str << "\": " << error << endl;
+      return 1;
+    }
+    opts.specs << spec;
+  }
+  opts.dryRun = parser.isSet(dryOpt);
+  opts.backup = parser.isSet(backupOpt);
+
+  const QStringList files = parser.positionalArguments();
+  if (files.isEmpty() || opts.specs.isEmpty()) {
+    parser.showHelp(1);
+  }
+
+  QElapsedTimer timer;
+  timer.start();
+
+  std::vector<Result> results(files.size());
+  Parallel::run(files.size(), [&](int i) {
+      results[i] = patchFile(files[i], opts);
+    }, parser.value(jobsOpt).toInt());
+
+  int failed{0};
+  bool quiet = parser.isSet(quietOpt);
+  for (int i = 0; i < files.size(); i++) {
+    const auto &res = results[i];
+    if (!res.ok) {
+      failed++;
+      err << files[i] << ": " << res.message << endl;
+    }
+    else if (!quiet) {
+      out << files[i] << ": " << res.message << endl;
+    }
+  }
+
+  if (!quiet) {
+    out << files.size() - failed << " of " << files.size() << " files "
+        << (opts.dryRun ? "verified" : "patched") << " in "
+        << timer.elapsed() << " ms" << endl;
+  }
+  return failed > 0 ? 2 : 0;
+}
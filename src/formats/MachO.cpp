@@ -2,10 +2,13 @@
 #include <QDebug>
 
 #include <cmath>
+#include <vector>
 
 #include "MachO.h"
 #include "../Util.h"
 #include "../Reader.h"
+#include "../Parallel.h"
+#include "../MappedFile.h"
 
 MachO::MachO(const QString &file) : Format(FormatType::MachO), file{file} { }
 
@@ -29,12 +32,22 @@ bool MachO::detect() {
 }
 
 bool MachO::parse() {
+  // Prefer reading from a memory map of the file so values are decoded
+  // straight from the mapped bytes, otherwise fall back to the device.
+  ReaderPtr reader;
   QFile f{file};
-  if (!f.open(QIODevice::ReadOnly)) {
-    return false;
+  mappedFile = MappedFile::map(file);
+  if (mappedFile) {
+    reader.reset(new Reader(mappedFile->getData(), mappedFile->getSize()));
+  }
+  else {
+    if (!f.open(QIODevice::ReadOnly)) {
+      return false;
+    }
+    reader.reset(new Reader(f));
   }
 
-  Reader r(f);
+  Reader &r = *reader;
   bool ok;
   quint32 magic = r.getUInt32(&ok);
   if (!ok) return false;
@@ -74,23 +87,44 @@ bool MachO::parse() {
       archs << puu(offset, size);
     }
 
-    // Parse the actual binary objects.
-    foreach (const auto &arch, archs) {
-      if (!parseHeader(arch.first, arch.second, r)) {
+    // Parse the actual binary objects. The slices are independent so
+    // parse them in parallel with a reader each if the file is mapped.
+    int count = archs.size();
+    std::vector<BinaryObjectPtr> parsed(count);
+    if (mappedFile && count > 1) {
+      Parallel::run(count, [&](int i) {
+          Reader sr(mappedFile->getData(), mappedFile->getSize());
+          parsed[i] = parseHeader(archs[i].first, archs[i].second, sr);
+        });
+    }
+    else {
+      for (int i = 0; i < count; i++) {
+        parsed[i] = parseHeader(archs[i].first, archs[i].second, r);
+      }
+    }
+
+    // Keep the order of the fat headers.
+    for (const auto &obj : parsed) {
+      if (obj == nullptr) {
         return false;
       }
+      objects << obj;
     }
   }
 
   // Otherwise, just parse a single object file.
   else {
-    return parseHeader(0, 0, r);
+    auto obj = parseHeader(0, 0, r);
+    if (obj == nullptr) {
+      return false;
+    }
+    objects << obj;
   }
 
   return true;
 }
 
-bool MachO::parseHeader(quint32 offset, quint32 size, Reader &r) {
+BinaryObjectPtr MachO::parseHeader(quint32 offset, quint32 size, Reader &r) {
   BinaryObjectPtr binaryObject(new BinaryObject);
 
   r.seek(offset);
@@ -98,7 +132,7 @@ bool MachO::parseHeader(quint32 offset, quint32 size, Reader &r) {
 
   bool ok;
   quint32 magic = r.getUInt32(&ok);
-  if (!ok) return false;
+  if (!ok) return nullptr;
 
   int systemBits{32};
   bool littleEndian{true};
@@ -128,22 +162,22 @@ bool MachO::parseHeader(quint32 offset, quint32 size, Reader &r) {
   quint32 cputype, cpusubtype, filetype, ncmds, sizeofcmds, flags;
 
   cputype = r.getUInt32(&ok);
-  if (!ok) return false;
+  if (!ok) return nullptr;
 
   cpusubtype = r.getUInt32(&ok);
-  if (!ok) return false;
+  if (!ok) return nullptr;
 
   filetype = r.getUInt32(&ok);
-  if (!ok) return false;
+  if (!ok) return nullptr;
 
   ncmds = r.getUInt32(&ok);
-  if (!ok) return false;
+  if (!ok) return nullptr;
 
   sizeofcmds = r.getUInt32(&ok);
-  if (!ok) return false;
+  if (!ok) return nullptr;
 
   flags = r.getUInt32(&ok);
-  if (!ok) return false;
+  if (!ok) return nullptr;
 
   // Read reserved field.
   if (systemBits == 64) {
@@ -279,14 +313,17 @@ bool MachO::parseHeader(quint32 offset, quint32 size, Reader &r) {
   // it.
   quint32 indirsymoff{0}, indirsymnum{0};
 
+  // Memory address of the __TEXT segment.
+  quint64 textVmaddr{0};
+
   // Parse load commands sequentially. Each consists of the type, size
   // and data.
   for (int i = 0; i < ncmds; i++) {
     quint32 type = r.getUInt32(&ok);
-    if (!ok) return false;
+    if (!ok) return nullptr;
 
     quint32 cmdsize = r.getUInt32(&ok);
-    if (!ok) return false;
+    if (!ok) return nullptr;
 
     // LC_SEGMENT or LC_SEGMENT_64
     if (type == 1 || type == 25) {
@@ -296,61 +333,65 @@ bool MachO::parseHeader(quint32 offset, quint32 size, Reader &r) {
       quint64 vmaddr;
       if (systemBits == 32) {
         vmaddr = r.getUInt32(&ok);
-        if (!ok) return false;
+        if (!ok) return nullptr;
       }
       else {
         vmaddr = r.getUInt64(&ok);
-        if (!ok) return false;
+        if (!ok) return nullptr;
       }
 
       // Memory size of this segment.
       quint64 vmsize;
       if (systemBits == 32) {
         vmsize = r.getUInt32(&ok);
-        if (!ok) return false;
+        if (!ok) return nullptr;
       }
       else {
         vmsize = r.getUInt64(&ok);
-        if (!ok) return false;
+        if (!ok) return nullptr;
       }
 
       // File offset of this segment.
       quint64 fileoff;
       if (systemBits == 32) {
         fileoff = r.getUInt32(&ok);
-        if (!ok) return false;
+        if (!ok) return nullptr;
       }
       else {
         fileoff = r.getUInt64(&ok);
-        if (!ok) return false;
+        if (!ok) return nullptr;
       }
 
       // Amount to map from the file.
       quint64 filesize;
       if (systemBits == 32) {
         filesize = r.getUInt32(&ok);
-        if (!ok) return false;
+        if (!ok) return nullptr;
       }
       else {
         filesize = r.getUInt64(&ok);
-        if (!ok) return false;
+        if (!ok) return nullptr;
       }
 
       // Maximum VM protection.
       r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // Initial VM protection.
       r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
+
+      if (name == "__TEXT") {
+        textVmaddr = vmaddr;
+      }
 
       // Number of sections in segment.
       quint32 nsects = r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // Flags.
       r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // Read sections.
       if (nsects > 0) {
@@ -363,43 +404,43 @@ bool MachO::parseHeader(quint32 offset, quint32 size, Reader &r) {
           quint64 addr;
           if (systemBits == 32) {
             addr = r.getUInt32(&ok);
-            if (!ok) return false;
+            if (!ok) return nullptr;
           }
           else {
             addr = r.getUInt64(&ok);
-            if (!ok) return false;
+            if (!ok) return nullptr;
           }
 
           // Size in bytes of this section.
           quint64 secsize;
           if (systemBits == 32) {
             secsize = r.getUInt32(&ok);
-            if (!ok) return false;
+            if (!ok) return nullptr;
           }
           else {
             secsize = r.getUInt64(&ok);
-            if (!ok) return false;
+            if (!ok) return nullptr;
           }
 
           // File offset of this section.
           quint32 secfileoff = r.getUInt32(&ok);
-          if (!ok) return false;
+          if (!ok) return nullptr;
 
           // Section alignment (power of 2).
           r.getUInt32(&ok);
-          if (!ok) return false;
+          if (!ok) return nullptr;
 
           // File offset of relocation entries.
           r.getUInt32(&ok);
-          if (!ok) return false;
+          if (!ok) return nullptr;
 
           // Number of relocation entries.
           r.getUInt32(&ok);
-          if (!ok) return false;
+          if (!ok) return nullptr;
 
           // Flags.
           r.getUInt32(&ok);
-          if (!ok) return false;
+          if (!ok) return nullptr;
 
           // Reserved fields.
           r.getUInt32();
@@ -445,62 +486,62 @@ bool MachO::parseHeader(quint32 offset, quint32 size, Reader &r) {
     else if (type == 0x22 || type == (0x22 | 0x80000000)) {
       // File offset to rebase info.
       r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // Size of rebase info.
       r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // File offset to binding info.
       r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // Size of binding info.
       r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // File offset to weak binding info.
       r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // Size of weak binding info.
       r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // File offset to lazy binding info.
       r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // Size of lazy binding info.
       r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // File offset to export info.
       r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // Size of export info.
       r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
     }
 
     // LC_SYMTAB
     else if (type == 2) {
       // Symbol table offset.
       symoff = r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // Number of symbol table entries.
       symnum = r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // String table offset.
       quint32 stroff = r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // String table size in bytes.
       quint32 strsize = r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       SectionPtr sec(new Section(SectionType::String,
                                  QObject::tr("String Table"),
@@ -512,94 +553,94 @@ bool MachO::parseHeader(quint32 offset, quint32 size, Reader &r) {
     else if (type == 0xB) {
       // Index to local symbols.
       r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // Number of local symbols.
       r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // Index to externally defined symbols.
       r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // Number of externally defined symbols.
       r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // Index to undefined defined symbols.
       r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // Number of undefined defined symbols.
       r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // File offset to table of contents.
       r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // Number of entries in the table of contents.
       r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // File offset to module table.
       r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // Number of module table entries.
       r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // File offset to referenced symbol table.
       r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // Number of referenced symbol table entries.
       r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // File offset to indirect symbol table.
       indirsymoff = r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // Number of indirect symbol table entries.
       indirsymnum = r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // File offset to external relocation entries.
       r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // Number of external relocation entries.
       r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // File offset to local relocation entries.
       r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // Number of local relocation entries.
       r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
     }
 
     // LC_LOAD_DYLIB, LC_ID_DYLIB or LC_LOAD_WEAK_DYLIB
     else if (type == 0xC || type == 0xD || type == 0x18 + 0x80000000) {
       // Library path name offset.
       quint32 liboffset = r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // Time stamp.
       r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // Current version.
       r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // Compatibility version.
       r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // Library path name.
       r.read(cmdsize - liboffset);
@@ -609,7 +650,7 @@ bool MachO::parseHeader(quint32 offset, quint32 size, Reader &r) {
     else if (type == 0xE || type == 0x27) {
       // Dynamic linker's path name.
       quint32 noffset = r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       r.read(cmdsize - noffset);
     }
@@ -623,29 +664,29 @@ bool MachO::parseHeader(quint32 offset, quint32 size, Reader &r) {
     else if (type == 0x24) {
       // Version (X.Y.Z is encoded in nibbles xxxx.yy.zz)
       r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // SDK version (X.Y.Z is encoded in nibbles xxxx.yy.zz)
       r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
     }
 
     // LC_SOURCE_VERSION
     else if (type == 0x2A) {
       // Version (A.B.C.D.E packed as a24.b10.c10.d10.e10)
       r.getUInt64(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
     }
 
     // LC_MAIN
     else if (type == (0x28 | 0x80000000)) {
       // File (__TEXT) offset of main()
       r.getUInt64(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // Initial stack size if not zero.
       r.getUInt64(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
     }
 
     // LC_FUNCTION_STARTS, LC_DYLIB_CODE_SIGN_DRS,
@@ -653,11 +694,11 @@ bool MachO::parseHeader(quint32 offset, quint32 size, Reader &r) {
     else if (type == 0x26 || type == 0x2B || type == 0x1E || type == 0x1D) {
       // File offset to data in __LINKEDIT segment.
       quint32 off = r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // File size of data in __LINKEDIT segment.
       quint32 siz = r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // LC_FUNCTION_STARTS
       if (type == 0x26) {
@@ -680,24 +721,24 @@ bool MachO::parseHeader(quint32 offset, quint32 size, Reader &r) {
     else if (type == 0x29) {
       // From mach_header to start of data range.
       r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // Number of bytes in data range.
       r.getUInt16(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // Dice kind value.
       r.getUInt16(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
     }
 
     // LC_THREAD or LC_UNIXTHREAD
     else if (type == 0x4 || type == 0x5) {
       quint32 flavor = r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       quint32 count = r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // Data.
       r.read(flavor * count);
@@ -707,7 +748,7 @@ bool MachO::parseHeader(quint32 offset, quint32 size, Reader &r) {
     else if (type == 0x1C + 0x80000000) {
       // Name offset.
       quint32 off = r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // Name.
       r.read(cmdsize - off);
@@ -725,36 +766,36 @@ bool MachO::parseHeader(quint32 offset, quint32 size, Reader &r) {
   quint32 symsize{0};
   SymbolTable symTable;
   if (symnum > 0) {
-    r.seek(symoff);
+    r.seek(offset + symoff);
     qint64 pos;
     for (int i = 0; i < symnum; i++) {
       pos = r.pos();
 
       // Index into the string table.
       quint32 index = r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // Type flag.
       r.getUChar(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // Section number or NO_SECT.
       r.getUChar(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // Description.
       r.getUInt16(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       // Value of the symbol (or stab offset).
       quint64 value;
       if (systemBits == 32) {
         value = r.getUInt32(&ok);
-        if (!ok) return false;
+        if (!ok) return nullptr;
       }
       else {
         value = r.getUInt64(&ok);
-        if (!ok) return false;
+        if (!ok) return nullptr;
       }
 
       symTable.addSymbol(SymbolEntry(index, value));
@@ -772,13 +813,13 @@ bool MachO::parseHeader(quint32 offset, quint32 size, Reader &r) {
   quint32 dynsymsize{0};
   SymbolTable dynsymTable;
   if (indirsymnum > 0) {
-    r.seek(indirsymoff);
+    r.seek(offset + indirsymoff);
     qint64 pos;
     for (int i = 0; i < indirsymnum; i++) {
       pos = r.pos();
 
       quint32 num = r.getUInt32(&ok);
-      if (!ok) return false;
+      if (!ok) return nullptr;
 
       dynsymTable.addSymbol(SymbolEntry(num, 0));
       dynsymsize += (r.pos() - pos);
@@ -790,17 +831,41 @@ bool MachO::parseHeader(quint32 offset, quint32 size, Reader &r) {
     binaryObject->addSection(sec);
   }
 
-  // Fill data of stored sections.
+  // Fill data of stored sections. If the file is mapped then the data
+  // is only loaded when first used.
   foreach (auto sec, binaryObject->getSections()) {
+    if (mappedFile) {
+      sec->setMappedFile(mappedFile);
+      continue;
+    }
     r.seek(sec->getOffset());
     sec->setData(r.read(sec->getSize()));
   }
 
+  // Decode function starts. They are ULEB128 encoded deltas where the
+  // first is relative to the start of the __TEXT segment, and the list
+  // ends with a zero.
+  auto funcStarts = binaryObject->getSection(SectionType::FuncStarts);
+  if (funcStarts) {
+    // Nothing is edited yet so this refers to the mapped bytes.
+    QByteArray data = funcStarts->read(0, funcStarts->getDataSize());
+    Reader fr(data.constData(), data.size());
+    QList<quint64> starts;
+    quint64 addr{textVmaddr};
+    while (!fr.atEnd()) {
+      quint64 delta = fr.getULEB128(&ok);
+      if (!ok || delta == 0) break;
+      addr += delta;
+      starts << addr;
+    }
+    binaryObject->setFunctionStarts(starts);
+  }
+
   // If symbol table loaded then merge string table entries into it.
   if (symnum > 0) {
     auto strTable = binaryObject->getSection(SectionType::String);
     if (strTable) {
-      auto &data = strTable->getData();
+      QByteArray data = strTable->read(0, strTable->getDataSize());
       auto &symbols = symTable.getSymbols();
       for (int h = 0; h < symbols.size(); h++) {
         auto &symbol = symbols[h];
@@ -813,6 +878,7 @@ bool MachO::parseHeader(quint32 offset, quint32 size, Reader &r) {
         symbol.setString(QString::fromUtf8(tmp));
       }
     }
+    symTable.buildIndex();
     binaryObject->setSymbolTable(symTable);
   }
 
@@ -836,9 +902,9 @@ bool MachO::parseHeader(quint32 offset, quint32 size, Reader &r) {
         }
       }
     }
+    dynsymTable.buildIndex();
     binaryObject->setDynSymbolTable(dynsymTable);
   }
 
-  objects << binaryObject;
-  return true;
+  return binaryObject;
 }
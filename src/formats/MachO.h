@@ -2,6 +2,7 @@
 #define BMOD_MACHO_FORMAT_H
 
 #include "Format.h"
+#include "../MappedFile.h"
 
 class Reader;
 
@@ -17,10 +18,18 @@ public:
   QList<BinaryObjectPtr> getObjects() const { return objects; }
 
 private:
-  bool parseHeader(quint32 offset, quint32 size, Reader &reader);
+  /**
+   * Parse the object file at the offset. Only uses the reader given so
+   * objects with separate readers can be parsed concurrently. Returns
+   * nullptr on failure.
+   */
+  BinaryObjectPtr parseHeader(quint32 offset, quint32 size, Reader &reader);
 
   QString file;
   QList<BinaryObjectPtr> objects;
+
+  // Sections load their data from this lazily, if mapped.
+  MappedFilePtr mappedFile;
 };
 
 #endif // BMOD_MACHO_FORMAT_H
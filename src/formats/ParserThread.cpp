@@ -0,0 +1,9 @@
+#include "ParserThread.h"
+
+ParserThread::ParserThread(FormatPtr fmt, QObject *parent)
+  : QThread(parent), fmt{fmt}, success{false}
+{ }
+
+void ParserThread::run() {
+  success = fmt->parse();
+}
@@ -0,0 +1,28 @@
+#ifndef BMOD_PARSER_THREAD_H
+#define BMOD_PARSER_THREAD_H
+
+#include <QThread>
+
+#include "Format.h"
+
+/**
+ * Parses a format on a worker thread so the caller can keep processing
+ * events meanwhile.
+ */
+class ParserThread : public QThread {
+  Q_OBJECT
+
+public:
+  ParserThread(FormatPtr fmt, QObject *parent = nullptr);
+
+  bool isSuccess() const { return success; }
+
+protected:
+  void run();
+
+private:
+  FormatPtr fmt;
+  bool success;
+};
+
+#endif // BMOD_PARSER_THREAD_H
@@ -1,26 +1,30 @@
+#include <QDir>
+#include <QFile>
 #include <QDebug>
 #include <QLabel>
 #include <QLineEdit>
+#include <QFileDialog>
 #include <QMessageBox>
+#include <QApplication>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QPushButton>
-#include <QApplication>
+#include <QProgressBar>
 #include <QProgressDialog>
 #include <QStyledItemDelegate>
 
 #include "../Util.h"
 #include "DisassemblyPane.h"
 #include "../asm/Disassembler.h"
-#include "../widgets/TreeWidget.h"
+#include "../asm/DisassemblerThread.h"
+#include "../asm/DisassemblyWriter.h"
+#include "../widgets/TreeView.h"
+#include "../widgets/DisassemblyModel.h"
 
 namespace {
   class ItemDelegate : public QStyledItemDelegate {
   public:
-    ItemDelegate(DisassemblyPane *pane, QTreeWidget *tree, BinaryObjectPtr obj,
-                 SectionPtr sec)
-      : pane{pane}, tree{tree}, obj{obj}, sec{sec}
-    { }
+    ItemDelegate(DisassemblyPane *pane) : pane{pane} { }
 
     QWidget *createEditor(QWidget *parent, const QStyleOptionViewItem &option,
                           const QModelIndex &index) const {
@@ -58,37 +62,9 @@ namespace {
         if (newStr == oldStr) {
           return;
         }
-        model->setData(index, newStr);
-        auto *item = tree->topLevelItem(index.row());
-        if (item) {
-          Util::setTreeItemMarked(item, index.column());
-
-          // Change region.
-          quint64 addr = item->text(0).toULongLong(nullptr, 16);
-          quint64 pos = addr - sec->getAddress();
-          QByteArray data = Util::hexToData(newStr.replace(" ", ""));
-          sec->setSubData(data, pos);
-
-          // Update disassembly.
-          auto tmpSec =
-            SectionPtr(new Section(SectionType::Text, QString(), addr, pos));
-          tmpSec->setData(data);
-
-          Disassembler dis(obj);
-          Disassembly result;
-          if (dis.disassemble(tmpSec, result)) {
-            item->setText(2, result.asmLines.join("   "));
-            if (result.asmLines.size() > 1) {
-              pane->showUpdateButton();
-              QMessageBox::information(nullptr, "bmod",
-                                       tr("Changes implied new code lines.") + "\n" +
-                                       tr("Disassemble again for clear representation."));
-            }
-          }
-          else {
-            item->setText(2, tr("Could not disassemble!"));
-          }
 
+        // The model changes the region and updates the disassembly.
+        if (model->setData(index, newStr)) {
           emit pane->modified();
         }
       }
@@ -96,20 +72,19 @@ namespace {
 
   private:
     DisassemblyPane *pane;
-    QTreeWidget *tree;
-    BinaryObjectPtr obj;
-    SectionPtr sec;
   };
 }
 
 DisassemblyPane::DisassemblyPane(BinaryObjectPtr obj, SectionPtr sec)
-  : Pane(Kind::Disassembly), obj{obj}, sec{sec}, shown{false}
+  : Pane(Kind::Disassembly), obj{obj}, sec{sec}, shown{false}, model{nullptr},
+  thread{nullptr}
 {
   createLayout();
+  connect(this, &Pane::modified, this, &DisassemblyPane::onModified);
 }
 
-void DisassemblyPane::showUpdateButton() {
-  updateBtn->show();
+DisassemblyPane::~DisassemblyPane() {
+  stopThread();
 }
 
 void DisassemblyPane::showEvent(QShowEvent *event) {
@@ -118,161 +93,204 @@ void DisassemblyPane::showEvent(QShowEvent *event) {
     shown = true;
     setup();
   }
-  else if (sec->isModified()) {
+  else {
+    // Edits change the time, and so does undoing all of them.
     QDateTime mod = sec->modifiedWhen();
-    if (secModified.isNull() || mod != secModified) {
+    if (mod != secModified) {
       secModified = mod;
       setup();
     }
   }
 }
 
-void DisassemblyPane::onUpdateClicked() {
-  setup();
+void DisassemblyPane::onPatched(SectionPtr sec, int pos, int size) {
+  if (sec != this->sec || !shown) {
+    return;
+  }
+
+  // A running thread decodes a copy made before the change, so start
+  // over if visible or else when shown next time.
+  if (thread) {
+    if (isVisible()) {
+      secModified = sec->modifiedWhen();
+      setup();
+    }
+    return;
+  }
+
+  model->updateRange(pos, size);
+  secModified = sec->modifiedWhen();
+}
+
+void DisassemblyPane::onModified() {
+  // Edits made here are decoded again right away, so don't start over
+  // when shown next time.
+  secModified = sec->modifiedWhen();
+}
+
+void DisassemblyPane::onCancelClicked() {
+  if (thread) {
+    thread->cancel();
+    cancelBtn->setEnabled(false);
+  }
+}
+
+void DisassemblyPane::onExportClicked() {
+  QFileDialog diag(this, tr("Export Disassembly"), QDir::homePath());
+  diag.setAcceptMode(QFileDialog::AcceptSave);
+  diag.setNameFilters(QStringList{"Assembly (*.s *.txt)", "Any file (*)"});
+  if (!diag.exec()) {
+    return;
+  }
+
+  QString file = diag.selectedFiles().first();
+  QFile f(file);
+  if (!f.open(QIODevice::WriteOnly | QIODevice::Text)) {
+    QMessageBox::warning(this, "bmod",
+                         tr("Could not open \"%1\" for writing!").arg(file));
+    return;
+  }
+
+  QProgressDialog progDiag(this);
+  progDiag.setWindowModality(Qt::WindowModal);
+  progDiag.setLabelText(tr("Exporting disassembly.."));
+  progDiag.setRange(0, 100);
+  progDiag.show();
+  qApp->processEvents();
+
+  // Decode again while writing instead of rendering the model, so the
+  // whole section is exported even if it is still being disassembled.
+  DisassemblyWriter writer(obj);
+  writer.setProgressFunc([&progDiag](qint64 pos, qint64 size) {
+      progDiag.setValue(size > 0 ? (long double) pos / size * 100.0 : 100);
+      qApp->processEvents();
+      return !progDiag.wasCanceled();
+    });
+  if (!writer.write(sec, &f)) {
+    f.remove();
+    if (!progDiag.wasCanceled()) {
+      QMessageBox::warning(this, "bmod", writer.getError());
+    }
+  }
+}
+
+void DisassemblyPane::onBatch(const Disassembly &batch, qint64 pos,
+                              qint64 size) {
+  // Ignore batches still queued from a stopped thread.
+  if (sender() != thread || thread->isCancelled()) {
+    return;
+  }
+
+  bool first = (model->rowCount() == 0);
+  model->appendDisassembly(batch);
+  if (first) {
+    treeView->setFocus();
+  }
+
+  int perc = (size > 0 ? (long double) pos / (long double) size * 100.0 : 100);
+  progressBar->setValue(perc);
+  label->setText(tr("%1 instructions (%2 of %3)")
+                 .arg(model->getInstructionCount())
+                 .arg(Util::formatSize(pos))
+                 .arg(Util::formatSize(size)));
+}
+
+void DisassemblyPane::onFinished() {
+  if (sender() != thread) {
+    return;
+  }
+
+  progressBar->hide();
+  cancelBtn->hide();
+
+  int count = model->getInstructionCount();
+  if (thread->isCancelled()) {
+    label->setText(tr("%1 instructions (cancelled)").arg(count));
+  }
+  else if (!thread->isSuccess() && count == 0) {
+    label->setText(tr("Could not disassemble machine code!"));
+  }
+  else {
+    label->setText(tr("%1 instructions").arg(count));
+  }
+
+  thread->deleteLater();
+  thread = nullptr;
 }
 
 void DisassemblyPane::createLayout() {
   label = new QLabel;
 
-  updateBtn = new QPushButton(tr("Update disassembly"));
-  updateBtn->hide();
-  connect(updateBtn, &QPushButton::clicked,
-          this, &DisassemblyPane::onUpdateClicked);
+  progressBar = new QProgressBar;
+  progressBar->setRange(0, 100);
+  progressBar->setMaximumWidth(200);
+  progressBar->hide();
+
+  cancelBtn = new QPushButton(tr("Cancel"));
+  cancelBtn->hide();
+  connect(cancelBtn, &QPushButton::clicked,
+          this, &DisassemblyPane::onCancelClicked);
+
+  exportBtn = new QPushButton(tr("Export.."));
+  connect(exportBtn, &QPushButton::clicked,
+          this, &DisassemblyPane::onExportClicked);
 
   auto *topLayout = new QHBoxLayout;
   topLayout->setContentsMargins(0, 0, 0, 0);
   topLayout->addWidget(label);
   topLayout->addStretch();
-  topLayout->addWidget(updateBtn);
-
-  treeWidget = new TreeWidget;
-  treeWidget->setHeaderLabels(QStringList{tr("Address"), tr("Data"), tr("Disassembly")});
-  treeWidget->setColumnWidth(0, obj->getSystemBits() == 64 ? 110 : 70);
-  treeWidget->setColumnWidth(1, 200);
-  treeWidget->setColumnWidth(2, 200);
-  treeWidget->setItemDelegate(new ItemDelegate(this, treeWidget, obj, sec));
-  treeWidget->setMachineCodeColumns(QList<int>{1});
-  treeWidget->setCpuType(obj->getCpuType());
-  treeWidget->setAddressColumn(0);
+  topLayout->addWidget(progressBar);
+  topLayout->addWidget(cancelBtn);
+  topLayout->addWidget(exportBtn);
+
+  model = new DisassemblyModel(obj, sec, this);
+
+  treeView = new TreeView;
+  treeView->setModel(model);
+  treeView->setColumnWidth(0, obj->getSystemBits() == 64 ? 110 : 70);
+  treeView->setColumnWidth(1, 200);
+  treeView->setColumnWidth(2, 200);
+  treeView->setItemDelegate(new ItemDelegate(this));
+  treeView->setMachineCodeColumns(QList<int>{1});
+  treeView->setCpuType(obj->getCpuType());
+  treeView->setAddressColumn(0);
 
   auto *layout = new QVBoxLayout;
   layout->setContentsMargins(0, 0, 0, 0);
   layout->addLayout(topLayout);
-  layout->addWidget(treeWidget);
+  layout->addWidget(treeView);
   
   setLayout(layout);
 }
 
 void DisassemblyPane::setup() {
-  updateBtn->hide();
-  treeWidget->clear();
-
-  QProgressDialog progDiag(this);
-  progDiag.setLabelText(tr("Disassembling data.."));
-  progDiag.setCancelButton(nullptr);
-  progDiag.setRange(0, 100);
-  progDiag.show();
-  qApp->processEvents();
-
-  quint64 addr = sec->getAddress();
-  quint32 pos = 0, size = sec->getSize();
-  const QByteArray &data = sec->getData();
-
-  const auto &symTable = obj->getSymbolTable();
-
-  Disassembler dis(obj);
-  Disassembly result;
-  if (dis.disassemble(sec, result)) {
-    int len = result.asmLines.size();
-    label->setText(tr("%1 instructions").arg(len));
-    for (int i = 0; i < len; i++) {
-      const QString &line = result.asmLines[i];
-      short bytes = result.bytesConsumed[i];
-
-      // Check if this is the beginning of a function.
-      QString funcName;
-      if (symTable.getString(addr, funcName)) {
-        auto *item = new QTreeWidgetItem;
-        item->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
-        int col{2};
-        item->setText(col, funcName);
-        auto font = item->font(col);
-        font.setBold(true);
-        item->setFont(col, font);
-        if (i > 0) {
-          treeWidget->addTopLevelItem(new QTreeWidgetItem);
-        }
-        treeWidget->addTopLevelItem(item);
-      }
-
-      auto *item = new QTreeWidgetItem;
-      item->setFlags(Qt::ItemIsEditable | Qt::ItemIsEnabled | Qt::ItemIsSelectable);
-      item->setText(0, Util::padString(QString::number(addr, 16).toUpper(),
-                                       obj->getSystemBits() / 8));
-
-      QString code;
-      for (int j = pos; j < pos + bytes && j < size; j++) {
-        QString hex =
-          Util::padString(QString::number((unsigned char) data[j], 16), 2);
-        code += hex + " ";
-      }
-      if (code.endsWith(" ")) {
-        code.chop(1);
-      }
-      code = code.toUpper();
-      item->setText(1, code);
-
-      item->setText(2, line);
-      treeWidget->addTopLevelItem(item);
-
-      addr += bytes;
-      pos += bytes;
-
-      static int lastPerc{0};
-      int perc = (long double) pos / (long double) size * 100.0;
-      if (perc > lastPerc || perc == 100) {
-        lastPerc = perc;
-        progDiag.setValue(perc);
-        progDiag.setLabelText(tr("Disassembling data.. %1% (%2 of %3)")
-                              .arg(perc)
-                              .arg(Util::formatSize(pos))
-                              .arg(Util::formatSize(size)));
-        qApp->processEvents();
-      }
-    }
-
-    // Mark items as modified if a region states it.
-    const auto &modRegs = sec->getModifiedRegions();
-    int rows = treeWidget->topLevelItemCount();
-    quint64 offset =
-      treeWidget->topLevelItem(0)->text(0).toULongLong(nullptr, 16);
-    for (int row = 0; row < rows; row++) {
-      auto *item = treeWidget->topLevelItem(row);
-      addr = item->text(0).toULongLong(nullptr, 16) - offset;
-      int size = item->text(1).split(" ", QString::SkipEmptyParts).size();
-      foreach (const auto &reg, modRegs) {
-        if (reg.first >= addr && reg.first < addr + size) {
-          Util::setTreeItemMarked(item, 1);
-          int excess = (reg.first + reg.second) - (addr + size);
-          if (excess > 0) {
-            for (int row2 = row + 1; row2 < rows; row2++) {
-              auto *item2 = treeWidget->topLevelItem(row2);
-              if (item2) {
-                int size2 = item2->text(1).split(" ", QString::SkipEmptyParts).size();
-                Util::setTreeItemMarked(item2, 1);
-                excess -= size2;
-                if (excess <= 0) break;
-              }
-              else break;
-            }
-          }
-        }
-      }
-    }
+  stopThread();
+  model->clear();
+
+  // Mnemonics are searched as decoded again, and hits are shown once
+  // their rows are.
+  treeView->setSection(obj, sec, SearchQuery::Kind::Mnemonic,
+                       [this](quint32 offset) {
+                         return model->getRow(offset);
+                       }, 2);
+
+  // Decode on a worker thread and show the instructions as they come.
+  thread = new DisassemblerThread(obj, sec, this);
+  connect(thread, &DisassemblerThread::batch,
+          this, &DisassemblyPane::onBatch);
+  connect(thread, &QThread::finished, this, &DisassemblyPane::onFinished);
+
+  label->setText(tr("Disassembling data.."));
+  progressBar->setValue(0);
+  progressBar->show();
+  cancelBtn->setEnabled(true);
+  cancelBtn->show();
+
+  thread->start();
+}
 
-    treeWidget->setFocus();
-  }
-  else {
-    label->setText(tr("Could not disassemble machine code!"));
-  }
+void DisassemblyPane::stopThread() {
+  if (!thread) return;
+  thread->stop();
+  thread = nullptr;
 }
@@ -2,34 +2,42 @@
 #define BMOD_DISASSEMBLY_PANE_H
 
 #include <QDateTime>
-#include <QTreeWidgetItem>
 
 #include "Pane.h"
 #include "../Section.h"
 #include "../BinaryObject.h"
+#include "../asm/Disassembler.h"
 
 class QLabel;
-class TreeWidget;
+class TreeView;
 class QPushButton;
+class QProgressBar;
+class DisassemblyModel;
+class DisassemblerThread;
 
 class DisassemblyPane : public Pane {
   Q_OBJECT
 
 public:
   DisassemblyPane(BinaryObjectPtr obj, SectionPtr sec);
+  ~DisassemblyPane();
 
-  void showUpdateButton();
+  void onPatched(SectionPtr sec, int pos, int size);
 
 protected:
   void showEvent(QShowEvent *event);
 
 private slots:
-  void onUpdateClicked();
+  void onModified();
+  void onCancelClicked();
+  void onExportClicked();
+  void onBatch(const Disassembly &batch, qint64 pos, qint64 size);
+  void onFinished();
 
 private:
   void createLayout();
   void setup();
-  void setItemMarked(QTreeWidgetItem *item, int column);
+  void stopThread();
 
   BinaryObjectPtr obj;
   SectionPtr sec;
@@ -37,8 +45,11 @@ private:
 
   bool shown;
   QLabel *label;
-  QPushButton *updateBtn;
-  TreeWidget *treeWidget;
+  QPushButton *cancelBtn, *exportBtn;
+  QProgressBar *progressBar;
+  TreeView *treeView;
+  DisassemblyModel *model;
+  DisassemblerThread *thread;
 };
 
 #endif // BMOD_DISASSEMBLY_PANE_H
@@ -9,8 +9,12 @@ GenericPane::GenericPane(BinaryObjectPtr obj, SectionPtr sec)
   createLayout();
 }
 
+void GenericPane::onPatched(SectionPtr sec, int pos, int size) {
+  codeWidget->onPatched(sec, pos, size);
+}
+
 void GenericPane::createLayout() {
-  auto *codeWidget = new MachineCodeWidget(obj, sec);
+  codeWidget = new MachineCodeWidget(obj, sec);
   connect(codeWidget, SIGNAL(modified()), this, SIGNAL(modified()));
 
   auto *layout = new QVBoxLayout;
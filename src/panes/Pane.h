@@ -3,6 +3,8 @@
 
 #include <QWidget>
 
+#include "../Section.h"
+
 class Pane : public QWidget {
   Q_OBJECT
 
@@ -13,6 +15,7 @@ public:
     Disassembly,
     Strings,
     Symbols,
+    Signatures,
     Generic
   };
 
@@ -25,6 +28,12 @@ protected:
 public:
   Kind getKind() const { return kind; }
 
+  /**
+   * Called when bytes of a section were changed outside of the pane,
+   * like by undo or redo, so it can update the affected rows.
+   */
+  virtual void onPatched(SectionPtr sec, int pos, int size) { }
+
 private:
   Kind kind;
 };
@@ -9,8 +9,12 @@ ProgramPane::ProgramPane(BinaryObjectPtr obj, SectionPtr sec)
   createLayout();
 }
 
+void ProgramPane::onPatched(SectionPtr sec, int pos, int size) {
+  codeWidget->onPatched(sec, pos, size);
+}
+
 void ProgramPane::createLayout() {
-  auto *codeWidget = new MachineCodeWidget(obj, sec);
+  codeWidget = new MachineCodeWidget(obj, sec);
   connect(codeWidget, SIGNAL(modified()), this, SIGNAL(modified()));
 
   auto *layout = new QVBoxLayout;
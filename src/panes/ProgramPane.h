@@ -5,15 +5,20 @@
 #include "../Section.h"
 #include "../BinaryObject.h"
 
+class MachineCodeWidget;
+
 class ProgramPane : public Pane {
 public:
   ProgramPane(BinaryObjectPtr obj, SectionPtr sec);
 
+  void onPatched(SectionPtr sec, int pos, int size);
+
 private:
   void createLayout();
 
   BinaryObjectPtr obj;
   SectionPtr sec;
+  MachineCodeWidget *codeWidget;
 };
 
 #endif // BMOD_PROGRAM_PANE_H
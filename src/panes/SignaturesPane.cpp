@@ -0,0 +1,164 @@
+#include <QFile>
+#include <QLabel>
+#include <QSettings>
+#include <QSplitter>
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QVBoxLayout>
+#include <QPlainTextEdit>
+
+#include "SignaturesPane.h"
+#include "../widgets/TreeView.h"
+#include "../SignatureScanThread.h"
+#include "../widgets/SignatureHitsModel.h"
+
+SignaturesPane::SignaturesPane(const QList<BinaryObjectPtr> &objects)
+  : Pane(Kind::Signatures), objects{objects}, scanThread{nullptr},
+  sigCount{0}
+{
+  createLayout();
+}
+
+SignaturesPane::~SignaturesPane() {
+  stopScan();
+}
+
+void SignaturesPane::onLoadClicked() {
+  QString file =
+    QFileDialog::getOpenFileName(this, tr("Load signatures"), QString(),
+                                 tr("Signatures (*.txt *.sig);;All (*)"));
+  if (file.isEmpty()) return;
+
+  QFile f(file);
+  if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    QMessageBox::warning(this, "bmod", tr("Could not read %1").arg(file));
+    return;
+  }
+  sigEdit->setPlainText(QString::fromUtf8(f.readAll()));
+}
+
+void SignaturesPane::onScanClicked() {
+  // The button stops a running scan.
+  if (scanThread) {
+    stopScan();
+    scanBtn->setText(tr("Scan"));
+    label->setText(tr("Scan stopped after %1 hits.")
+                   .arg(model->rowCount()));
+    return;
+  }
+
+  SignatureScanner scanner;
+  QString error, text = sigEdit->toPlainText();
+  if (!scanner.parse(text, &error)) {
+    QMessageBox::warning(this, "bmod", error);
+    return;
+  }
+  sigCount = scanner.getSignatureCount();
+  if (sigCount == 0) {
+    label->setText(tr("No signatures to scan for."));
+    return;
+  }
+
+  QSettings settings;
+  settings.setValue("SignaturesPane_signatures", text);
+
+  QStringList names;
+  for (int i = 0; i < sigCount; i++) {
+    names << scanner.getName(i);
+  }
+  model->clear(names);
+
+  // Hits are shown in batches while the rest is scanned.
+  scanThread = new SignatureScanThread(scanner, objects, this);
+  connect(scanThread, &SignatureScanThread::hits,
+          this, &SignaturesPane::onScanHits);
+  connect(scanThread, &QThread::finished,
+          this, &SignaturesPane::onScanFinished);
+  scanBtn->setText(tr("Stop"));
+  label->setText(tr("Scanning for signatures.."));
+  scanTimer.start();
+  scanThread->start();
+}
+
+void SignaturesPane::onScanHits(const SignatureHits &hits, int sections,
+                                int total) {
+  if (sender() != scanThread || scanThread->isCancelled()) {
+    return;
+  }
+
+  model->appendHits(hits);
+  label->setText(tr("Scanning for signatures.. %1 hits, %2 of %3 sections")
+                 .arg(model->rowCount()).arg(sections).arg(total));
+}
+
+void SignaturesPane::onScanFinished() {
+  if (sender() != scanThread) {
+    return;
+  }
+
+  scanThread->deleteLater();
+  scanThread = nullptr;
+  scanBtn->setText(tr("Scan"));
+  label->setText(tr("%1 hits of %2 signatures in %3 ms")
+                 .arg(model->rowCount()).arg(sigCount)
+                 .arg(scanTimer.elapsed()));
+}
+
+void SignaturesPane::stopScan() {
+  if (!scanThread) return;
+  scanThread->stop();
+  scanThread = nullptr;
+}
+
+void SignaturesPane::createLayout() {
+  sigEdit = new QPlainTextEdit;
+  sigEdit->setFont(QFont("Courier"));
+  sigEdit->setPlaceholderText(tr("One signature per line, like:\n"
+                                 "prologue = 55 48 89 E5 ?? 83"));
+
+  QSettings settings;
+  sigEdit->setPlainText(settings.value("SignaturesPane_signatures")
+                        .toString());
+
+  auto *loadBtn = new QPushButton(tr("Load.."));
+  connect(loadBtn, &QPushButton::clicked,
+          this, &SignaturesPane::onLoadClicked);
+
+  scanBtn = new QPushButton(tr("Scan"));
+  connect(scanBtn, &QPushButton::clicked,
+          this, &SignaturesPane::onScanClicked);
+
+  label = new QLabel;
+
+  auto *topLayout = new QHBoxLayout;
+  topLayout->setContentsMargins(0, 0, 0, 0);
+  topLayout->addWidget(label);
+  topLayout->addStretch();
+  topLayout->addWidget(loadBtn);
+  topLayout->addWidget(scanBtn);
+
+  model = new SignatureHitsModel(this);
+
+  treeView = new TreeView;
+  treeView->setModel(model);
+  treeView->setColumnWidth(0, 100);
+  treeView->setColumnWidth(1, 100);
+  treeView->setColumnWidth(2, 110);
+  treeView->setColumnWidth(3, 70);
+  treeView->setColumnWidth(4, 200);
+  treeView->setAddressColumn(2);
+
+  auto *splitter = new QSplitter(Qt::Vertical);
+  splitter->addWidget(sigEdit);
+  splitter->addWidget(treeView);
+  splitter->setStretchFactor(1, 1);
+
+  auto *layout = new QVBoxLayout;
+  layout->setContentsMargins(0, 0, 0, 0);
+  layout->addLayout(topLayout);
+  layout->addWidget(splitter);
+
+  setLayout(layout);
+}
@@ -0,0 +1,51 @@
+#ifndef BMOD_SIGNATURES_PANE_H
+#define BMOD_SIGNATURES_PANE_H
+
+#include <QList>
+#include <QElapsedTimer>
+
+#include "Pane.h"
+#include "../BinaryObject.h"
+#include "../SignatureScanner.h"
+
+class QLabel;
+class TreeView;
+class QPushButton;
+class QPlainTextEdit;
+class SignatureHitsModel;
+class SignatureScanThread;
+
+/**
+ * Scans all objects of a binary for byte signatures entered as "name =
+ * bytes" lines, see SignatureScanner, and lists where they were found.
+ */
+class SignaturesPane : public Pane {
+  Q_OBJECT
+
+public:
+  SignaturesPane(const QList<BinaryObjectPtr> &objects);
+  ~SignaturesPane();
+
+private slots:
+  void onLoadClicked();
+  void onScanClicked();
+  void onScanHits(const SignatureHits &hits, int sections, int total);
+  void onScanFinished();
+
+private:
+  void createLayout();
+  void stopScan();
+
+  QList<BinaryObjectPtr> objects;
+  SignatureScanThread *scanThread;
+  QElapsedTimer scanTimer;
+  int sigCount;
+
+  QLabel *label;
+  QPushButton *scanBtn;
+  QPlainTextEdit *sigEdit;
+  SignatureHitsModel *model;
+  TreeView *treeView;
+};
+
+#endif // BMOD_SIGNATURES_PANE_H
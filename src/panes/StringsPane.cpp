@@ -1,22 +1,22 @@
 #include <QDebug>
 #include <QLabel>
-#include <QSplitter>
+#include <QSpinBox>
+#include <QCheckBox>
 #include <QLineEdit>
+#include <QHBoxLayout>
 #include <QVBoxLayout>
-#include <QApplication>
-#include <QProgressDialog>
 #include <QStyledItemDelegate>
 
 #include "../Util.h"
 #include "StringsPane.h"
-#include "../widgets/TreeWidget.h"
+#include "../StringScanner.h"
+#include "../widgets/TreeView.h"
+#include "../widgets/StringsModel.h"
 
 namespace {
   class ItemDelegate : public QStyledItemDelegate {
   public:
-    ItemDelegate(StringsPane *pane, QTreeWidget *tree, SectionPtr sec)
-      : pane{pane}, tree{tree}, sec{sec}
-    { }
+    ItemDelegate(StringsPane *pane) : pane{pane} { }
 
     QWidget *createEditor(QWidget *parent, const QStyleOptionViewItem &option,
                           const QModelIndex &index) const {
@@ -52,23 +52,9 @@ namespace {
         if (newStr == oldStr) {
           return;
         }
-        model->setData(index, newStr);
-        auto *item = tree->topLevelItem(index.row());
-        if (item) {
-          Util::setTreeItemMarked(item, index.column());
-
-          // Update string representation.
-          item->setText(1, Util::hexToString(newStr)
-                        .replace("\n", "\\n")
-                        .replace("\t", "\\t")
-                        .replace("\r", "\\r"));
-
-          // Change region.
-          quint64 addr = item->text(0).toULongLong(nullptr, 16);
-          quint64 pos = addr - sec->getAddress();
-          QByteArray data = Util::hexToData(newStr);
-          sec->setSubData(data, pos);
 
+        // The model changes the region and updates the row.
+        if (model->setData(index, newStr)) {
           emit pane->modified();
         }
       }
@@ -76,13 +62,12 @@ namespace {
 
   private:
     StringsPane *pane;
-    QTreeWidget *tree;
-    SectionPtr sec;
   };
 }
 
-StringsPane::StringsPane(BinaryObjectPtr obj, SectionPtr sec)
-  : Pane(Kind::Strings), obj{obj}, sec{sec}, shown{false}
+StringsPane::StringsPane(BinaryObjectPtr obj, SectionPtr sec, Mode mode)
+  : Pane(Kind::Strings), obj{obj}, sec{sec}, mode{mode}, shown{false},
+  minLenSpin{nullptr}, utf16Chk{nullptr}
 {
   createLayout();
 }
@@ -93,134 +78,158 @@ void StringsPane::showEvent(QShowEvent *event) {
     shown = true;
     setup();
   }
-  else if (sec->isModified()) {
+  else {
+    // Edits change the time, and so does undoing all of them.
     QDateTime mod = sec->modifiedWhen();
-    if (secModified.isNull() || mod != secModified) {
+    if (mod != secModified) {
       secModified = mod;
       setup();
     }
   }
 }
 
+void StringsPane::onPatched(SectionPtr sec, int pos, int size) {
+  // Strings might be split or joined by the change so find those around
+  // it again, now if visible or else all when shown next time.
+  if (sec != this->sec || !isVisible()) {
+    return;
+  }
+  secModified = sec->modifiedWhen();
+  updateSpans(pos, size);
+  showInfo();
+}
+
+void StringsPane::onOptionsChanged() {
+  if (shown) {
+    setup();
+  }
+}
+
 void StringsPane::createLayout() {
   label = new QLabel;
 
-  treeWidget = new TreeWidget;
-  treeWidget->setHeaderLabels(QStringList{tr("Address"), tr("String"),
-        tr("Length"), tr("Data")});
-  treeWidget->setColumnWidth(0, obj->getSystemBits() == 64 ? 110 : 70);
-  treeWidget->setColumnWidth(1, 200);
-  treeWidget->setColumnWidth(2, 50);
-  treeWidget->setColumnWidth(3, 200);
-  treeWidget->setItemDelegate(new ItemDelegate(this, treeWidget, sec));
-  treeWidget->setAddressColumn(0);
+  auto *topLayout = new QHBoxLayout;
+  topLayout->setContentsMargins(0, 0, 0, 0);
+  topLayout->addWidget(label);
+
+  if (mode == Mode::Any) {
+    minLenSpin = new QSpinBox;
+    minLenSpin->setRange(2, 1024);
+    minLenSpin->setValue(4);
+    connect(minLenSpin,
+            static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+            this, &StringsPane::onOptionsChanged);
+
+    utf16Chk = new QCheckBox(tr("UTF-16"));
+    utf16Chk->setChecked(true);
+    connect(utf16Chk, &QCheckBox::toggled,
+            this, &StringsPane::onOptionsChanged);
+
+    topLayout->addStretch();
+    topLayout->addWidget(new QLabel(tr("Minimum length:")));
+    topLayout->addWidget(minLenSpin);
+    topLayout->addWidget(utf16Chk);
+  }
+
+  model = new StringsModel(obj, sec, this);
+
+  treeView = new TreeView;
+  treeView->setModel(model);
+  treeView->setColumnWidth(0, obj->getSystemBits() == 64 ? 110 : 70);
+  treeView->setColumnWidth(1, 200);
+  treeView->setColumnWidth(2, 50);
+  treeView->setColumnWidth(3, 200);
+  treeView->setItemDelegate(new ItemDelegate(this));
+  treeView->setAddressColumn(0);
 
   auto *layout = new QVBoxLayout;
   layout->setContentsMargins(0, 0, 0, 0);
-  layout->addWidget(label);
-  layout->addWidget(treeWidget);
-  
+  layout->addLayout(topLayout);
+  layout->addWidget(treeView);
+
   setLayout(layout);
 }
 
 void StringsPane::setup() {
-  treeWidget->clear();
-
-  quint64 addr = sec->getAddress();
-  const QByteArray &data = sec->getData();
-  if (data.isEmpty()) {
-    return;
+  // Only the spans are found here, in parallel, and the rows are
+  // decoded when shown.
+  QByteArray data = sec->read(0, sec->getDataSize());
+  if (mode == Mode::Terminated) {
+    model->setSpans(StringScanner::split(data), true);
+  }
+  else {
+    model->setSpans(StringScanner::find(data, minLenSpin->value(),
+                                        utf16Chk->isChecked()), false);
   }
 
-  int len = data.size();
-
-  QProgressDialog progDiag(this);
-  progDiag.setLabelText(tr("Processing strings.."));
-  progDiag.setCancelButton(nullptr);
-  progDiag.setRange(0, 100);
-  progDiag.show();
-  qApp->processEvents();
-
-  QByteArray cur;
-  for (int i = 0; i < len; i++) {
-    char c = data[i];
-    cur += c;
-    if (c == 0) {
-      auto *item = new QTreeWidgetItem;
-      item->setFlags(Qt::ItemIsEditable | Qt::ItemIsEnabled | Qt::ItemIsSelectable);
-      item->setText(0, Util::padString(QString::number(addr, 16).toUpper(),
-                                       obj->getSystemBits() / 8));
-
-      QString str = QString::fromUtf8(cur);
-      str = str.replace("\n", "\\n").replace("\t", "\\t").replace("\r", "\\r");
-
-      item->setText(1, str);
-      item->setText(2, QString::number(str.size()));
-
-      QString dataStr;
-      for (int j = 0; j < cur.size(); j++) {
-        QString hex =
-          Util::padString(QString::number((unsigned char) cur[j], 16), 2);
-        dataStr += hex;
-      }
-      item->setText(3, dataStr.toUpper());
-
-      treeWidget->addTopLevelItem(item);
-      addr += cur.size();
-      cur.clear();
-
-      static int lastPerc{0};
-      int perc = (float) i / (float) len * 100.0;
-      if (perc > lastPerc || perc == 100) {
-        lastPerc = perc;
-        progDiag.setValue(perc);
-        progDiag.setLabelText(tr("Processing strings.. %1% (%2 of %3)")
-                              .arg(perc)
-                              .arg(Util::formatSize(i))
-                              .arg(Util::formatSize(len)));
-        qApp->processEvents();
-      }
-    }
+  // The rows changed so searches start over.
+  treeView->setSection(obj, sec, SearchQuery::Kind::Ascii,
+                       [this](quint32 offset) {
+                         return model->getRow(offset);
+                       }, 1);
+
+  showInfo();
+  if (!data.isEmpty()) {
+    treeView->setFocus();
   }
+}
 
-  // Mark items as modified if a region states it.
-  const auto &modRegs = sec->getModifiedRegions();
-  int rows = treeWidget->topLevelItemCount();
-  quint64 offset =
-    treeWidget->topLevelItem(0)->text(0).toULongLong(nullptr, 16);
-  for (int row = 0; row < rows; row++) {
-    auto *item = treeWidget->topLevelItem(row);
-    addr = item->text(0).toULongLong(nullptr, 16) - offset;
-    int size = item->text(2).toInt() + 1; // account for \0
-    foreach (const auto &reg, modRegs) {
-      if (reg.first >= addr && reg.first < addr + size) {
-        Util::setTreeItemMarked(item, 3);
-        int excess = (reg.first + reg.second) - (addr + size);
-        if (excess > 0) {
-          for (int row2 = row + 1; row2 < rows; row2++) {
-            auto *item2 = treeWidget->topLevelItem(row2);
-            if (item2) {
-              int size2 = item2->text(2).toInt() + 1; // account for \0
-              Util::setTreeItemMarked(item2, 3);
-              excess -= size2;
-              if (excess <= 0) break;
-            }
-            else break;
-          }
-        }
-      }
-    }
+void StringsPane::showInfo() {
+  int len = sec->getDataSize();
+  if (len == 0) {
+    label->setText(tr("Defined but empty."));
+    return;
   }
 
   int padSize = obj->getSystemBits() / 8;
-  addr = sec->getAddress();
+  quint64 addr = sec->getAddress();
   label->setText(tr("Section size: %1, address %2 to %3, %4 rows")
                  .arg(Util::formatSize(len))
                  .arg(Util::padString(QString::number(addr, 16).toUpper(),
                                       padSize))
                  .arg(Util::padString(QString::number(addr + len, 16).toUpper(),
                                       padSize))
-                 .arg(treeWidget->topLevelItemCount()));
+                 .arg(model->rowCount()));
+}
 
-  treeWidget->setFocus();
+void StringsPane::updateSpans(int pos, int size) {
+  // Grow a window around the changed bytes until no string crosses its
+  // ends, judging by unchanged bytes so the old strings end there too.
+  // Then only the strings of the window are found again.
+  bool terminated = (mode == Mode::Terminated);
+  qint64 secSize = sec->getDataSize(), end = pos + size;
+  for (qint64 margin = 256; ; margin *= 2) {
+    // UTF-16 strings are at even offsets.
+    qint64 first = qMax<qint64>(0, pos - margin) & ~1,
+      last = qMin(secSize, end + margin);
+    QByteArray data = sec->read(first, last - first);
+
+    int from = pos - first;
+    while (from > 0 && !StringScanner::isBoundary(data, from, terminated)) {
+      from--;
+    }
+    int to = qMin<int>(end + 2 - first, data.size());
+    while (to < data.size() &&
+           !StringScanner::isBoundary(data, to, terminated)) {
+      to++;
+    }
+    if ((from == 0 && first > 0) || (to == data.size() && last < secSize)) {
+      continue;
+    }
+
+    QByteArray part = data.mid(from, to - from);
+    StringScanner::Spans spans;
+    if (terminated) {
+      spans = StringScanner::split(part);
+    }
+    else {
+      spans = StringScanner::find(part, minLenSpin->value(),
+                                  utf16Chk->isChecked());
+    }
+    for (auto &span : spans) {
+      span.offset += first + from;
+    }
+    model->replaceSpans(first + from, first + to, spans);
+    return;
+  }
 }
@@ -2,34 +2,56 @@
 #define BMOD_STRINGS_PANE_H
 
 #include <QDateTime>
-#include <QTreeWidgetItem>
 
 #include "Pane.h"
 #include "../Section.h"
 #include "../BinaryObject.h"
 
 class QLabel;
-class TreeWidget;
+class QSpinBox;
+class QCheckBox;
+class TreeView;
+class StringsModel;
 
 class StringsPane : public Pane {
+  Q_OBJECT
+
 public:
-  StringsPane(BinaryObjectPtr obj, SectionPtr sec);
+  enum class Mode {
+    Terminated, // NUL-terminated strings, like of __cstring.
+    Any // Runs of text in any data, with a minimum length.
+  };
+
+  StringsPane(BinaryObjectPtr obj, SectionPtr sec,
+              Mode mode = Mode::Terminated);
+
+  void onPatched(SectionPtr sec, int pos, int size);
 
 protected:
   void showEvent(QShowEvent *event);
 
+private slots:
+  void onOptionsChanged();
+
 private:
   void createLayout();
   void setup();
-  void setItemMarked(QTreeWidgetItem *item, int column);
+  void showInfo();
+
+  // Find the strings around changed bytes again.
+  void updateSpans(int pos, int size);
 
   BinaryObjectPtr obj;
   SectionPtr sec;
+  Mode mode;
   QDateTime secModified;
 
   bool shown;
   QLabel *label;
-  TreeWidget *treeWidget;
+  QSpinBox *minLenSpin;
+  QCheckBox *utf16Chk;
+  TreeView *treeView;
+  StringsModel *model;
 };
 
 #endif // BMOD_STRINGS_PANE_H
@@ -63,7 +63,7 @@ void SymbolsPane::setup() {
   }
 
   int padSize = obj->getSystemBits() / 8;
-  qint64 len = sec->getData().size();
+  qint64 len = sec->getDataSize();
   quint64 addr = sec->getAddress();
   label->setText(tr("Section size: %1, address %2 to %3, %4 rows")
                  .arg(Util::formatSize(len))
@@ -1,4 +1,3 @@
-#include <QFile>
 #include <QDebug>
 #include <QListWidget>
 #include <QHBoxLayout>
@@ -9,6 +8,7 @@
 
 #include "Util.h"
 #include "BinaryWidget.h"
+#include "../CommitWriter.h"
 
 #include "../panes/Pane.h"
 #include "../panes/ArchPane.h"
@@ -17,19 +17,14 @@
 #include "../panes/StringsPane.h"
 #include "../panes/GenericPane.h"
 #include "../panes/DisassemblyPane.h"
+#include "../panes/SignaturesPane.h"
 
 BinaryWidget::BinaryWidget(FormatPtr fmt) : fmt{fmt} {
   createLayout();
   setup();
 }
 
-void BinaryWidget::commit() {
-  QFile f(getFile());
-  if (!f.open(QIODevice::ReadWrite)) {
-    QMessageBox::critical(this, "bmod", tr("Could not open file for writing!"));
-    return;
-  }
-
+bool BinaryWidget::commit(QString *summary) {
   QProgressDialog progDiag(this);
   progDiag.setLabelText(tr("Committing to file.."));
   progDiag.setCancelButton(nullptr);
@@ -37,18 +32,53 @@ void BinaryWidget::commit() {
   progDiag.show();
   qApp->processEvents();
 
+  CommitWriter writer(getFile());
+  foreach (const auto obj, fmt->getObjects()) {
+    writer.addObject(obj);
+  }
+
+  if (!writer.commit()) {
+    progDiag.close();
+    QMessageBox::critical(this, "bmod", writer.getError());
+    return false;
+  }
+
+  if (summary) {
+    *summary =
+      tr("Wrote %1 bytes in %2 regions to \"%3\" in %4 ms")
+      .arg(writer.getBytesWritten()).arg(writer.getRegionCount())
+      .arg(getFile()).arg(writer.getElapsed());
+  }
+
+  // Undoing past this point must write the original bytes again.
   foreach (const auto obj, fmt->getObjects()) {
+    obj->getJournal().setSaved();
     foreach (const auto sec, obj->getSections()) {
-      if (!sec->isModified()) {
-        continue;
-      }
-      const QByteArray &data = sec->getData();
-      foreach (const auto &region, sec->getModifiedRegions()) {
-        f.seek(sec->getOffset() + region.first);
-        f.write(data.mid(region.first, region.second));
-      }
+      sec->setCommitted();
+    }
+  }
+  return true;
+}
+
+bool BinaryWidget::isModified() const {
+  foreach (const auto obj, fmt->getObjects()) {
+    if (!obj->getJournal().isSaved()) {
+      return true;
     }
   }
+  return false;
+}
+
+bool BinaryWidget::undo() {
+  auto obj = getCurrentObject();
+  if (!obj) return false;
+  return notifyPatched(obj, obj->getJournal().undo());
+}
+
+bool BinaryWidget::redo() {
+  auto obj = getCurrentObject();
+  if (!obj) return false;
+  return notifyPatched(obj, obj->getJournal().redo());
 }
 
 void BinaryWidget::createLayout() {
@@ -72,67 +102,101 @@ void BinaryWidget::onModeChanged(int row) {
   stackLayout->setCurrentIndex(row);
 }
 
+BinaryObjectPtr BinaryWidget::getCurrentObject() const {
+  int idx = stackLayout->currentIndex();
+  if (idx < 0 || idx >= paneObjects.size()) {
+    return nullptr;
+  }
+  return paneObjects[idx];
+}
+
+bool BinaryWidget::notifyPatched(BinaryObjectPtr obj,
+                                 const PatchJournal::Patch *patch) {
+  if (!patch) {
+    return false;
+  }
+
+  // Only the panes of the object can show the section.
+  for (int i = 0; i < panes.size(); i++) {
+    if (paneObjects[i] == obj) {
+      panes[i]->onPatched(patch->section, patch->pos, patch->oldData.size());
+    }
+  }
+  emit modified();
+  return true;
+}
+
 void BinaryWidget::setup() {
   foreach (const auto obj, fmt->getObjects()) {
     auto *archPane = new ArchPane(fmt->getType(), obj);
     QString cpuStr = Util::cpuTypeString(obj->getCpuType()),
       cpuSubStr = Util::cpuTypeString(obj->getCpuSubType());
-    addPane(tr("%1 (%2)").arg(cpuStr).arg(cpuSubStr), archPane);
+    addPane(obj, tr("%1 (%2)").arg(cpuStr).arg(cpuSubStr), archPane);
 
     SectionPtr sec = obj->getSection(SectionType::Text);
     if (sec) {
-      addPane(tr("Executable Code"), new ProgramPane(obj, sec), 1);
-      addPane(tr("Disassembly"), new DisassemblyPane(obj, sec), 2);
+      addPane(obj, tr("Executable Code"), new ProgramPane(obj, sec), 1);
+      addPane(obj, tr("Disassembly"), new DisassemblyPane(obj, sec), 2);
+      addPane(obj, tr("Strings"),
+              new StringsPane(obj, sec, StringsPane::Mode::Any), 2);
     }
 
     sec = obj->getSection(SectionType::SymbolStubs);
     if (sec) {
-      addPane(sec->getName(), new GenericPane(obj, sec), 1);
+      addPane(obj, sec->getName(), new GenericPane(obj, sec), 1);
     }
 
     sec = obj->getSection(SectionType::Symbols);
     if (sec) {
-      addPane(sec->getName(),
+      addPane(obj, sec->getName(),
               new SymbolsPane(obj, sec, SymbolsPane::Type::Symbols), 1);
-      addPane(tr("Raw View"), new GenericPane(obj, sec), 2);
+      addPane(obj, tr("Raw View"), new GenericPane(obj, sec), 2);
     }
 
     sec = obj->getSection(SectionType::DynSymbols);
     if (sec) {
-      addPane(sec->getName(),
+      addPane(obj, sec->getName(),
               new SymbolsPane(obj, sec, SymbolsPane::Type::DynSymbols), 1);
-      addPane(tr("Raw View"), new GenericPane(obj, sec), 2);
+      addPane(obj, tr("Raw View"), new GenericPane(obj, sec), 2);
     }
 
     sec = obj->getSection(SectionType::String);
     if (sec) {
-      addPane(sec->getName(), new StringsPane(obj, sec), 1);
-      addPane(tr("Raw View"), new GenericPane(obj, sec), 2);
+      addPane(obj, sec->getName(), new StringsPane(obj, sec), 1);
+      addPane(obj, tr("Raw View"), new GenericPane(obj, sec), 2);
     }
 
     foreach (auto sec, obj->getSectionsByType(SectionType::CString)) {
-      addPane(sec->getName(), new StringsPane(obj, sec), 1);
-      addPane(tr("Raw View"), new GenericPane(obj, sec), 2);
+      addPane(obj, sec->getName(), new StringsPane(obj, sec), 1);
+      addPane(obj, tr("Raw View"), new GenericPane(obj, sec), 2);
     }
 
     sec = obj->getSection(SectionType::FuncStarts);
     if (sec) {
-      addPane(sec->getName(), new GenericPane(obj, sec), 1);
+      addPane(obj, sec->getName(), new GenericPane(obj, sec), 1);
     }
 
     sec = obj->getSection(SectionType::CodeSig);
     if (sec) {
-      addPane(sec->getName(), new GenericPane(obj, sec), 1);
+      addPane(obj, sec->getName(), new GenericPane(obj, sec), 1);
+      addPane(obj, tr("Strings"),
+              new StringsPane(obj, sec, StringsPane::Mode::Any), 2);
     }
   }
 
+  // Scans all objects so it doesn't belong to any of them.
+  addPane(nullptr, tr("Signatures"), new SignaturesPane(fmt->getObjects()));
+
   if (listWidget->count() > 0) {
     listWidget->setCurrentRow(0);
   }
 }
 
-void BinaryWidget::addPane(const QString &title, Pane *pane, int level) {
+void BinaryWidget::addPane(BinaryObjectPtr obj, const QString &title,
+                           Pane *pane, int level) {
   listWidget->addItem(QString(level * 4, ' ') + title);
   stackLayout->addWidget(pane);
+  panes << pane;
+  paneObjects << obj;
   connect(pane, SIGNAL(modified()), this, SIGNAL(modified()));
 }
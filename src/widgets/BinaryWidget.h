@@ -1,6 +1,7 @@
 #ifndef BMOD_BINARY_WIDGET_H
 #define BMOD_BINARY_WIDGET_H
 
+#include <QList>
 #include <QWidget>
 
 #include "../formats/Format.h"
@@ -16,8 +17,24 @@ public:
   BinaryWidget(FormatPtr fmt);
 
   QString getFile() const { return fmt->getFile(); }
+  QList<BinaryObjectPtr> getObjects() const { return fmt->getObjects(); }
 
-  void commit();
+  /**
+   * Commit the modifications to the file. On success a summary of what
+   * was written is put in summary if given.
+   */
+  bool commit(QString *summary = nullptr);
+
+  // Whether there are patches that weren't committed, or were undone
+  // since.
+  bool isModified() const;
+
+  /**
+   * Undo or redo the latest patch of the object of the current pane.
+   * Returns false if there was nothing to undo or redo.
+   */
+  bool undo();
+  bool redo();
 
 signals:
   void modified();
@@ -28,9 +45,15 @@ private slots:
 private:
   void createLayout();
   void setup();
-  void addPane(const QString &title, Pane *pane, int level = 0);
+  void addPane(BinaryObjectPtr obj, const QString &title, Pane *pane,
+               int level = 0);
+
+  BinaryObjectPtr getCurrentObject() const;
+  bool notifyPatched(BinaryObjectPtr obj, const PatchJournal::Patch *patch);
   
   FormatPtr fmt;
+  QList<Pane*> panes;
+  QList<BinaryObjectPtr> paneObjects; // Object of each pane.
 
   QListWidget *listWidget;
   QStackedLayout *stackLayout;
@@ -9,8 +9,8 @@
 #include <QVBoxLayout>
 #include <QMessageBox>
 
-#include "../Util.h"
 #include "../BinaryObject.h"
+#include "WidgetUtil.h"
 #include "DisassemblerDialog.h"
 #include "../asm/Disassembler.h"
 
@@ -21,7 +21,7 @@ DisassemblerDialog::DisassemblerDialog(QWidget *parent, CpuType cpuType,
   setWindowTitle(tr("Disassembler"));
   createLayout();
   resize(400, 300);
-  Util::centerWidget(this);
+  WidgetUtil::centerWidget(this);
 
   if (!data.isEmpty()) {
     machineText->setText(data);
@@ -44,7 +44,7 @@ void DisassemblerDialog::onConvert() {
   Disassembler dis(obj);
   Disassembly result;
   if (dis.disassemble(text, result, offset)) {
-    asmText->setText(result.asmLines.join("\n"));
+    asmText->setText(dis.getText(result));
     setAsmVisible();
   }
   else {
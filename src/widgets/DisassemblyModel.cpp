@@ -0,0 +1,362 @@
+#include <QFont>
+#include <QBrush>
+
+#include <algorithm>
+
+#include "../Util.h"
+#include "DisassemblyModel.h"
+
+DisassemblyModel::DisassemblyModel(BinaryObjectPtr obj, SectionPtr sec,
+                                   QObject *parent)
+  : QAbstractTableModel(parent), obj{obj}, sec{sec},
+  addrLen{obj->getSystemBits() / 8}, dis{obj}, nextOffset{0}, instCount{0}
+{ }
+
+int DisassemblyModel::rowCount(const QModelIndex &parent) const {
+  if (parent.isValid()) return 0;
+  return rows.size();
+}
+
+int DisassemblyModel::columnCount(const QModelIndex &parent) const {
+  if (parent.isValid()) return 0;
+  return 3;
+}
+
+QVariant DisassemblyModel::data(const QModelIndex &index, int role) const {
+  if (!index.isValid() || index.row() >= rows.size()) {
+    return QVariant();
+  }
+
+  const Row &row = rows[index.row()];
+  int col = index.column();
+  if (row.type == RowType::Spacer) {
+    return QVariant();
+  }
+
+  if (row.type == RowType::Function) {
+    if (col != 2) {
+      return QVariant();
+    }
+    if (role == Qt::DisplayRole) {
+      return funcNames[row.index];
+    }
+    if (role == Qt::FontRole) {
+      QFont font("Courier");
+      font.setBold(true);
+      return font;
+    }
+    return QVariant();
+  }
+
+  switch (role) {
+  case Qt::DisplayRole:
+  case Qt::EditRole:
+    switch (col) {
+    case 0:
+      return Util::padString(QString::number(sec->getAddress() + row.offset,
+                                             16).toUpper(), addrLen);
+
+    case 1:
+      return Util::dataToHex(sec->read(row.offset, row.length), 0, row.length);
+
+    case 2:
+      // Only the returned copy allocates, not the rendering.
+      dis.render(disasm, row.index, line);
+      return QString(line.constData(), line.size());
+    }
+    break;
+
+  case Qt::ToolTipRole:
+    if (col == 0) {
+      // Label the address with the function enclosing it.
+      QString name;
+      quint64 addr = sec->getAddress() + row.offset, start;
+      if (obj->getSymbolTable().getEnclosingString(addr, name, &start)) {
+        if (addr == start) {
+          return name;
+        }
+        return QString("%1 + 0x%2").arg(name)
+          .arg(QString::number(addr - start, 16).toUpper());
+      }
+    }
+    break;
+
+  case Qt::FontRole:
+    if (col == 1 && isMarked(row)) {
+      QFont font("Courier");
+      font.setBold(true);
+      return font;
+    }
+    break;
+
+  case Qt::ForegroundRole:
+    if (col == 1 && isMarked(row)) {
+      return QBrush(Qt::red);
+    }
+    break;
+  }
+
+  return QVariant();
+}
+
+bool DisassemblyModel::setData(const QModelIndex &index, const QVariant &value,
+                               int role) {
+  if (!index.isValid() || role != Qt::EditRole || index.column() != 1 ||
+      index.row() >= rows.size()) {
+    return false;
+  }
+
+  const Row &row = rows[index.row()];
+  if (row.type != RowType::Instruction) {
+    return false;
+  }
+
+  QString str = value.toString();
+  QByteArray data = Util::hexToData(str.replace(" ", ""));
+  if (data.isEmpty()) {
+    return false;
+  }
+
+  // Change region and decode the affected instructions again.
+  if (!obj->getJournal().write(sec, data, row.offset)) {
+    return false;
+  }
+  redecode(index.row(), row.offset + data.size());
+  return true;
+}
+
+QVariant DisassemblyModel::headerData(int section, Qt::Orientation orientation,
+                                      int role) const {
+  if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+    return QVariant();
+  }
+
+  switch (section) {
+  case 0: return tr("Address");
+  case 1: return tr("Data");
+  case 2: return tr("Disassembly");
+  }
+  return QVariant();
+}
+
+Qt::ItemFlags DisassemblyModel::flags(const QModelIndex &index) const {
+  if (!index.isValid() || index.row() >= rows.size()) {
+    return Qt::NoItemFlags;
+  }
+
+  Qt::ItemFlags flags = Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+  if (rows[index.row()].type == RowType::Instruction) {
+    flags |= Qt::ItemIsEditable;
+  }
+  return flags;
+}
+
+void DisassemblyModel::appendDisassembly(const Disassembly &result) {
+  int first = disasm.size(), len = result.size();
+  if (len == 0) {
+    return;
+  }
+
+  // The lines know their offsets into the section, so bytes that were
+  // skipped can't shift the rows after them.
+  QVector<Row> newRows;
+  newRows.reserve(len);
+  for (int i = 0; i < len; i++) {
+    addRows(newRows, result.getOffset(i), result.getLength(i), first + i);
+  }
+  quint32 offset = result.getOffset(len - 1) + result.getLength(len - 1);
+
+  int row = rows.size();
+  beginInsertRows(QModelIndex(), row, row + newRows.size() - 1);
+  disasm.appendAll(result);
+  rows << newRows;
+  nextOffset = offset;
+  instCount += len;
+  endInsertRows();
+}
+
+void DisassemblyModel::clear() {
+  beginResetModel();
+  disasm = Disassembly();
+  funcNames.clear();
+  freeLines.clear();
+  freeNames.clear();
+  rows.clear();
+  nextOffset = 0;
+  instCount = 0;
+  endResetModel();
+}
+
+void DisassemblyModel::updateRange(quint32 pos, quint32 size) {
+  if (rows.isEmpty() || pos >= nextOffset || size == 0) {
+    return;
+  }
+
+  int row = getRow(pos);
+  if (row == -1) {
+    return;
+  }
+  redecode(row, pos + size);
+}
+
+int DisassemblyModel::getRow(quint32 offset) const {
+  // Last row starting at or before the offset, which is the
+  // instruction containing it since names precede their instruction.
+  auto it = std::upper_bound(rows.constBegin(), rows.constEnd(), offset,
+                             [](quint32 offset, const Row &row) {
+                               return offset < row.offset;
+                             });
+  if (it == rows.constBegin() || offset >= nextOffset) {
+    return -1;
+  }
+  return it - rows.constBegin() - 1;
+}
+
+void DisassemblyModel::addRows(QVector<Row> &out, quint32 offset,
+                               quint16 bytes, int index, bool checkFunc) {
+  // Check if this is the beginning of a function.
+  QString funcName;
+  if (checkFunc &&
+      obj->getSymbolTable().getString(sec->getAddress() + offset, funcName)) {
+    if (!rows.isEmpty() || !out.isEmpty()) {
+      out << Row{RowType::Spacer, 0, offset, -1};
+    }
+    int name;
+    if (!freeNames.isEmpty()) {
+      name = freeNames.takeLast();
+      funcNames[name] = funcName;
+    }
+    else {
+      name = funcNames.size();
+      funcNames << funcName;
+    }
+    out << Row{RowType::Function, 0, offset, name};
+  }
+
+  // Don't show machine code past the end of the section.
+  quint32 size = sec->getDataSize();
+  quint16 length = bytes;
+  if (offset + length > size) {
+    length = (offset < size ? size - offset : 0);
+  }
+  out << Row{RowType::Instruction, length, offset, index};
+}
+
+void DisassemblyModel::redecode(int row, quint32 end) {
+  // Longest possible x86 instruction, so a line that ends closer than
+  // this to the end of a window might have been cut off.
+  const quint32 maxInstLen = 15;
+
+  quint32 start = rows[row].offset, limit = nextOffset;
+
+  Disassembly lines;
+  quint32 cur{start};
+  int last{row}; // Row at the realigned boundary.
+  bool aligned{false};
+  for (quint32 window = 256; !aligned; window *= 2) {
+    quint32 winEnd = qMin(limit, start + window);
+    bool atLimit = (winEnd == limit);
+
+    auto part =
+      SectionPtr(new Section(sec->getType(), sec->getName(),
+                             sec->getAddress() + start, winEnd - start,
+                             sec->getOffset() + start));
+    part->setData(sec->read(start, winEnd - start));
+
+    Disassembly result;
+    dis.disassemble(part, result);
+
+    // Take lines until one ends on an old instruction boundary at or
+    // after the edited bytes.
+    lines = Disassembly();
+    cur = start;
+    last = row;
+    for (int i = 0; i < result.size(); i++) {
+      quint32 next = start + result.getOffset(i) + result.getLength(i);
+      if (!atLimit && next + maxInstLen > winEnd) break;
+
+      lines.append(result, i);
+      cur = next;
+
+      if (cur >= end) {
+        while (last < rows.size() && rows[last].offset < cur) {
+          last++;
+        }
+        if (last < rows.size() && rows[last].offset == cur) {
+          aligned = true;
+          break;
+        }
+      }
+    }
+
+    if (!aligned && atLimit) {
+      last = rows.size();
+      break;
+    }
+  }
+
+  if (lines.isEmpty()) {
+    return;
+  }
+
+  // Reuse the line and name indices of the replaced rows so repeated
+  // edits don't grow them.
+  int replaced{0};
+  for (int i = row; i < last; i++) {
+    if (rows[i].type == RowType::Instruction) {
+      freeLines << rows[i].index;
+      replaced++;
+    }
+    else if (rows[i].type == RowType::Function) {
+      freeNames << rows[i].index;
+    }
+  }
+
+  // The lines were decoded from the start of the window.
+  QVector<Row> newRows;
+  for (int i = 0; i < lines.size(); i++) {
+    int index;
+    if (!freeLines.isEmpty()) {
+      index = freeLines.takeLast();
+      disasm.replace(index, lines, i, start);
+    }
+    else {
+      index = disasm.size();
+      disasm.append(lines, i, start);
+    }
+
+    // The function name of the first instruction is already present.
+    addRows(newRows, start + lines.getOffset(i), lines.getLength(i), index,
+            i > 0);
+  }
+  instCount += lines.size() - replaced;
+
+  // Update the rows in place as far as possible, and insert or remove
+  // the rest.
+  int oldCount = last - row, newCount = newRows.size(),
+    common = qMin(oldCount, newCount);
+  for (int i = 0; i < common; i++) {
+    rows[row + i] = newRows[i];
+  }
+  if (common > 0) {
+    emit dataChanged(index(row, 0), index(row + common - 1, 2));
+  }
+
+  if (newCount > oldCount) {
+    beginInsertRows(QModelIndex(), row + common, row + newCount - 1);
+    for (int i = common; i < newCount; i++) {
+      rows.insert(row + i, newRows[i]);
+    }
+    endInsertRows();
+  }
+  else if (oldCount > newCount) {
+    beginRemoveRows(QModelIndex(), row + common, row + oldCount - 1);
+    rows.remove(row + common, oldCount - common);
+    endRemoveRows();
+  }
+}
+
+bool DisassemblyModel::isMarked(const Row &row) const {
+  int start = row.offset;
+  return sec->getModifiedRegions().intersects(start, start + row.length);
+}
@@ -0,0 +1,103 @@
+#ifndef BMOD_DISASSEMBLY_MODEL_H
+#define BMOD_DISASSEMBLY_MODEL_H
+
+#include <QVector>
+#include <QStringList>
+#include <QAbstractTableModel>
+
+#include "../Section.h"
+#include "../BinaryObject.h"
+#include "../asm/Disassembler.h"
+
+/**
+ * Disassembly of a section as address, machine code and instruction
+ * columns. Only a compact record is kept per row and the text of the
+ * columns is produced when the view asks for it.
+ */
+class DisassemblyModel : public QAbstractTableModel {
+  Q_OBJECT
+
+public:
+  DisassemblyModel(BinaryObjectPtr obj, SectionPtr sec,
+                   QObject *parent = nullptr);
+
+  int rowCount(const QModelIndex &parent = QModelIndex()) const;
+  int columnCount(const QModelIndex &parent = QModelIndex()) const;
+
+  QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+  bool setData(const QModelIndex &index, const QVariant &value,
+               int role = Qt::EditRole);
+
+  QVariant headerData(int section, Qt::Orientation orientation,
+                      int role = Qt::DisplayRole) const;
+  Qt::ItemFlags flags(const QModelIndex &index) const;
+
+  /**
+   * Append the next decoded lines of the section, and insert function
+   * names before the instructions that start them.
+   */
+  void appendDisassembly(const Disassembly &result);
+  void clear();
+
+  int getInstructionCount() const { return instCount; }
+
+  /**
+   * Decode the instructions of the bytes again after they were changed
+   * elsewhere. Bytes not decoded yet are left alone.
+   */
+  void updateRange(quint32 pos, quint32 size);
+
+  /**
+   * Row of the instruction containing the byte at offset, or -1 if it
+   * isn't decoded yet.
+   */
+  int getRow(quint32 offset) const;
+
+private:
+  enum class RowType : quint8 {
+    Instruction,
+    Function, // Name of the function starting at the next instruction.
+    Spacer // Empty row before a function name.
+  };
+
+  struct Row {
+    RowType type;
+    quint16 length; // Bytes of instruction.
+    quint32 offset; // Into section data.
+    int index; // Into disassembly lines or function names.
+  };
+
+  // Add the rows of an instruction, preceded by the name of the
+  // function it starts if any.
+  void addRows(QVector<Row> &out, quint32 offset, quint16 bytes, int index,
+               bool checkFunc = true);
+
+  /**
+   * Decode again from the instruction of the row until the instruction
+   * stream realigns with the old boundaries, at or after the end, and
+   * replace the rows in between.
+   */
+  void redecode(int row, quint32 end);
+
+  bool isMarked(const Row &row) const;
+
+  BinaryObjectPtr obj;
+  SectionPtr sec;
+  int addrLen;
+
+  // Decodes edited bytes again and renders the shown lines.
+  Disassembler dis;
+  Disassembly disasm;
+
+  // Rendering buffer of the shown lines, which keeps its capacity.
+  mutable QString line;
+  QStringList funcNames;
+  QVector<Row> rows;
+
+  // Line and name indices no longer used by any row.
+  QVector<int> freeLines, freeNames;
+  quint32 nextOffset; // Of the next appended instruction.
+  int instCount;
+};
+
+#endif // BMOD_DISASSEMBLY_MODEL_H
@@ -0,0 +1,143 @@
+#include <QFont>
+#include <QBrush>
+
+#include "../Util.h"
+#include "MachineCodeModel.h"
+
+MachineCodeModel::MachineCodeModel(BinaryObjectPtr obj, SectionPtr sec,
+                                   QObject *parent)
+  : QAbstractTableModel(parent), obj{obj}, sec{sec}, rows{0},
+  addrLen{obj->getSystemBits() / 8}
+{
+  reload();
+}
+
+int MachineCodeModel::rowCount(const QModelIndex &parent) const {
+  if (parent.isValid()) return 0;
+  return rows;
+}
+
+int MachineCodeModel::columnCount(const QModelIndex &parent) const {
+  if (parent.isValid()) return 0;
+  return 4;
+}
+
+QVariant MachineCodeModel::data(const QModelIndex &index, int role) const {
+  if (!index.isValid()) {
+    return QVariant();
+  }
+
+  int row = index.row(), col = index.column();
+  if (row < 0 || row >= rows) {
+    return QVariant();
+  }
+
+  switch (role) {
+  case Qt::DisplayRole:
+  case Qt::EditRole:
+    if (col == 0) {
+      return formatAddress(row);
+    }
+    else {
+      QByteArray data = sec->read(row * 16, 16);
+      switch (col) {
+      case 1: return Util::dataToHex(data, 0, 8);
+      case 2: return Util::dataToHex(data, 8, 8);
+      case 3: return Util::dataToAscii(data, 0, 16);
+      }
+    }
+    break;
+
+  case Qt::FontRole:
+    if (isMarked(row, col)) {
+      QFont font("Courier");
+      font.setBold(true);
+      return font;
+    }
+    break;
+
+  case Qt::ForegroundRole:
+    if (isMarked(row, col)) {
+      return QBrush(Qt::red);
+    }
+    break;
+  }
+
+  return QVariant();
+}
+
+bool MachineCodeModel::setData(const QModelIndex &index, const QVariant &value,
+                               int role) {
+  int col = index.column();
+  if (!index.isValid() || role != Qt::EditRole || (col != 1 && col != 2)) {
+    return false;
+  }
+
+  QString str = value.toString();
+  QByteArray data = Util::hexToData(str.replace(" ", ""));
+  if (data.isEmpty()) {
+    return false;
+  }
+
+  int row = index.row();
+  if (!obj->getJournal().write(sec, data, row * 16 + (col - 1) * 8)) {
+    return false;
+  }
+
+  // Data column and ASCII representation changed.
+  emit dataChanged(this->index(row, col), this->index(row, 3));
+  return true;
+}
+
+QVariant MachineCodeModel::headerData(int section, Qt::Orientation orientation,
+                                      int role) const {
+  if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+    return QVariant();
+  }
+
+  switch (section) {
+  case 0: return tr("Address");
+  case 1: return tr("Data Low");
+  case 2: return tr("Data High");
+  case 3: return tr("ASCII");
+  }
+  return QVariant();
+}
+
+Qt::ItemFlags MachineCodeModel::flags(const QModelIndex &index) const {
+  if (!index.isValid()) {
+    return Qt::NoItemFlags;
+  }
+  return Qt::ItemIsEditable | Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+}
+
+void MachineCodeModel::reload() {
+  beginResetModel();
+  int len = sec->getDataSize();
+  rows = len / 16;
+  if (len % 16 > 0) rows++;
+  endResetModel();
+}
+
+void MachineCodeModel::updateRange(int pos, int size) {
+  if (rows == 0 || size <= 0) {
+    return;
+  }
+  int first = qMin(pos / 16, rows - 1),
+    last = qMin((pos + size - 1) / 16, rows - 1);
+  emit dataChanged(index(first, 1), index(last, 3));
+}
+
+QString MachineCodeModel::formatAddress(int row) const {
+  quint64 addr = sec->getAddress() + (quint64) row * 16;
+  return Util::padString(QString::number(addr, 16).toUpper(), addrLen);
+}
+
+bool MachineCodeModel::isMarked(int row, int column) const {
+  if (column != 1 && column != 2) {
+    return false;
+  }
+
+  int start = row * 16 + (column - 1) * 8;
+  return sec->getModifiedRegions().intersects(start, start + 8);
+}
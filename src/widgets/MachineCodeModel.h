@@ -0,0 +1,51 @@
+#ifndef BMOD_MACHINE_CODE_MODEL_H
+#define BMOD_MACHINE_CODE_MODEL_H
+
+#include <QAbstractTableModel>
+
+#include "../Section.h"
+#include "../BinaryObject.h"
+
+/**
+ * Hex view of a section with 16 bytes per row: address, low and high 8
+ * bytes, and the ASCII representation. Rows are formatted on demand
+ * from the section data so memory use is independent of section size.
+ */
+class MachineCodeModel : public QAbstractTableModel {
+  Q_OBJECT
+
+public:
+  MachineCodeModel(BinaryObjectPtr obj, SectionPtr sec,
+                   QObject *parent = nullptr);
+
+  int rowCount(const QModelIndex &parent = QModelIndex()) const;
+  int columnCount(const QModelIndex &parent = QModelIndex()) const;
+
+  QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+  bool setData(const QModelIndex &index, const QVariant &value,
+               int role = Qt::EditRole);
+
+  QVariant headerData(int section, Qt::Orientation orientation,
+                      int role = Qt::DisplayRole) const;
+  Qt::ItemFlags flags(const QModelIndex &index) const;
+
+  /**
+   * Reload after the section data was changed elsewhere.
+   */
+  void reload();
+
+  // Update the rows of the bytes after they were changed elsewhere.
+  void updateRange(int pos, int size);
+
+private:
+  QString formatAddress(int row) const;
+
+  // Whether the data column of the row overlaps a modified region.
+  bool isMarked(int row, int column) const;
+
+  BinaryObjectPtr obj;
+  SectionPtr sec;
+  int rows, addrLen;
+};
+
+#endif // BMOD_MACHINE_CODE_MODEL_H
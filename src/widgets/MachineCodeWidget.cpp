@@ -2,21 +2,17 @@
 #include <QLabel>
 #include <QLineEdit>
 #include <QVBoxLayout>
-#include <QTreeWidget>
-#include <QApplication>
-#include <QProgressDialog>
 #include <QStyledItemDelegate>
 
 #include "../Util.h"
-#include "TreeWidget.h"
+#include "TreeView.h"
+#include "MachineCodeModel.h"
 #include "MachineCodeWidget.h"
 
 namespace {
   class ItemDelegate : public QStyledItemDelegate {
   public:
-    ItemDelegate(MachineCodeWidget *widget, QTreeWidget *tree, SectionPtr sec)
-      : widget{widget}, tree{tree}, sec{sec}
-    { }
+    ItemDelegate(MachineCodeWidget *widget) : widget{widget} { }
 
     QWidget *createEditor(QWidget *parent, const QStyleOptionViewItem &option,
                           const QModelIndex &index) const {
@@ -54,29 +50,9 @@ namespace {
         if (newStr == oldStr) {
           return;
         }
-        model->setData(index, newStr);
-        auto *item = tree->topLevelItem(index.row());
-        if (item) {
-          int col = index.column();
-          Util::setTreeItemMarked(item, col);
-
-          // Generate new ASCII representation.
-          QString oldAscii = item->text(3);
-          QString newAscii = Util::hexToAscii(newStr, 0, 8);
-          if (col == 1) {
-            newAscii += oldAscii.mid(8);
-          }
-          else {
-            newAscii = oldAscii.mid(0, 8) + newAscii;
-          }
-          item->setText(3, newAscii);
-
-          // Change region.
-          quint64 addr = item->text(0).toULongLong(nullptr, 16);
-          quint64 pos = (addr - sec->getAddress()) + (col - 1) * 8;
-          QByteArray data = Util::hexToData(newStr.replace(" ", ""));
-          sec->setSubData(data, pos);
 
+        // The model changes the region of the section.
+        if (model->setData(index, newStr)) {
           emit widget->modified();
         }
       }
@@ -84,13 +60,11 @@ namespace {
 
   private:
     MachineCodeWidget *widget;
-    QTreeWidget *tree;
-    SectionPtr sec;
   };
 }
 
 MachineCodeWidget::MachineCodeWidget(BinaryObjectPtr obj, SectionPtr sec)
-  : obj{obj}, sec{sec}, shown{false}
+  : obj{obj}, sec{sec}, shown{false}, model{nullptr}
 {
   setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
   createLayout();
@@ -102,140 +76,72 @@ void MachineCodeWidget::showEvent(QShowEvent *event) {
     shown = true;
     setup();
   }
-  else if (sec->isModified()) {
+  else {
+    // Edits change the time, and so does undoing all of them.
     QDateTime mod = sec->modifiedWhen();
-    if (secModified.isNull() || mod != secModified) {
+    if (mod != secModified) {
       secModified = mod;
       setup();
     }
   }
 }
 
+void MachineCodeWidget::onPatched(SectionPtr sec, int pos, int size) {
+  if (sec != this->sec || !shown) {
+    return;
+  }
+  model->updateRange(pos, size);
+  secModified = sec->modifiedWhen();
+}
+
 void MachineCodeWidget::createLayout() {
   label = new QLabel;
 
-  treeWidget = new TreeWidget;
-  treeWidget->setHeaderLabels(QStringList{tr("Address"), tr("Data Low"),
-        tr("Data High"), tr("ASCII")});
-  treeWidget->setColumnWidth(0, obj->getSystemBits() == 64 ? 110 : 70);
-  treeWidget->setColumnWidth(1, 200);
-  treeWidget->setColumnWidth(2, 200);
-  treeWidget->setColumnWidth(3, 110);
-  treeWidget->setItemDelegate(new ItemDelegate(this, treeWidget, sec));
-  treeWidget->setMachineCodeColumns(QList<int>{1, 2});
-  treeWidget->setCpuType(obj->getCpuType());
-  treeWidget->setAddressColumn(0);
+  model = new MachineCodeModel(obj, sec, this);
+
+  treeView = new TreeView;
+  treeView->setModel(model);
+  treeView->setColumnWidth(0, obj->getSystemBits() == 64 ? 110 : 70);
+  treeView->setColumnWidth(1, 200);
+  treeView->setColumnWidth(2, 200);
+  treeView->setColumnWidth(3, 110);
+  treeView->setItemDelegate(new ItemDelegate(this));
+  treeView->setMachineCodeColumns(QList<int>{1, 2});
+  treeView->setCpuType(obj->getCpuType());
+  treeView->setAddressColumn(0);
+  treeView->setSection(obj, sec, SearchQuery::Kind::Hex,
+                       [](quint32 offset) {
+                         return int(offset / 16);
+                       }, 1);
 
   auto *layout = new QVBoxLayout;
   layout->setContentsMargins(0, 0, 0, 0);
   layout->addWidget(label);
-  layout->addWidget(treeWidget);
+  layout->addWidget(treeView);
   
   setLayout(layout);
 }
 
 void MachineCodeWidget::setup() {
-  treeWidget->clear();
-
-  quint64 addr = sec->getAddress();
-  const QByteArray &data = sec->getData();
-  int len = data.size(), rows = len / 16;
+  // Rows are formatted on demand so only the size needs refreshing.
+  model->reload();
 
+  int len = sec->getDataSize();
   if (len == 0) {
     label->setText(tr("Defined but empty."));
-    treeWidget->hide();
+    treeView->hide();
     return;
   }
 
-  if (len % 16 > 0) rows++;
-
-  QProgressDialog progDiag(this);
-  progDiag.setLabelText(tr("Processing data.."));
-  progDiag.setCancelButton(nullptr);
-  progDiag.setRange(0, 100);
-  progDiag.show();
-  qApp->processEvents();
-
-  for (int row = 0, byte = 0; row < rows; row++) {
-    auto *item = new QTreeWidgetItem;
-    item->setFlags(Qt::ItemIsEditable | Qt::ItemIsEnabled | Qt::ItemIsSelectable);
-    item->setText(0, Util::padString(QString::number(addr, 16).toUpper(),
-                                     obj->getSystemBits() / 8));
-
-    QString code, ascii;
-    for (int cur = 0; cur < 16 && byte < len; cur++, byte++) {
-      QString hex =
-        Util::padString(QString::number((unsigned char) data[byte], 16), 2);
-      code += hex + " ";
-
-      ascii += Util::dataToAscii(data, byte, 1);
-    }
-    if (code.endsWith(" ")) {
-      code.chop(1);
-    }
-    code = code.toUpper();
-    item->setText(1, code.mid(0, 8 * 3));
-    item->setText(2, code.mid(8 * 3));
-    item->setText(3, ascii);
-
-    treeWidget->addTopLevelItem(item);
-    addr += 16;
-
-    static int lastPerc{0};
-    int perc = (float) row / (float) rows * 100.0;
-    if (perc > lastPerc || perc == 100) {
-      lastPerc = perc;
-      progDiag.setValue(perc);
-      progDiag.setLabelText(tr("Processing data.. %1% (%2 of %3)")
-                            .arg(perc)
-                            .arg(Util::formatSize(byte))
-                            .arg(Util::formatSize(len)));
-      qApp->processEvents();
-    }
-  }
-
-  // Mark items as modified if a region states it.
-  const auto &modRegs = sec->getModifiedRegions();
-  for (int row = 0, byte = 0; row < rows; row++, byte += 16) {
-    auto *item = treeWidget->topLevelItem(row);
-    foreach (const auto &reg, modRegs) {
-      if (reg.first >= byte && reg.first < byte + 16) {
-        int col1 = 1, col2 = 2;
-        if (reg.first < byte + 8) {
-          Util::setTreeItemMarked(item, col1);
-        }
-        if (reg.first + reg.second >= byte + 8) {
-          Util::setTreeItemMarked(item, col2);
-        }
-        if (reg.first + reg.second > byte + 16) {
-          // Number of additional rows to mark.
-          int num = ((reg.first + reg.second) - (byte + 16)) / 16;
-          for (int j = 0; j < num + 1; j++) {
-            item = treeWidget->topLevelItem(row + j + 1);
-            if (item) {
-              Util::setTreeItemMarked(item, col1);
-
-              // If intermediate rows or if the data actually spans
-              // the last column.
-              if (j < num || (reg.first + reg.second) % 16 > 8) {
-                Util::setTreeItemMarked(item, col2);
-              }
-            }
-          }
-        }
-      }
-    }
-  }
-
   int padSize = obj->getSystemBits() / 8;
-  addr = sec->getAddress();
+  quint64 addr = sec->getAddress();
   label->setText(tr("Section size: %1, address %2 to %3, %4 rows")
                  .arg(Util::formatSize(len))
                  .arg(Util::padString(QString::number(addr, 16).toUpper(),
                                       padSize))
                  .arg(Util::padString(QString::number(addr + len, 16).toUpper(),
                                       padSize))
-                 .arg(treeWidget->topLevelItemCount()));
+                 .arg(model->rowCount()));
 
-  treeWidget->setFocus();
+  treeView->setFocus();
 }
@@ -8,8 +8,8 @@
 #include "../BinaryObject.h"
 
 class QLabel;
-class TreeWidget;
-class QTreeWidgetItem;
+class TreeView;
+class MachineCodeModel;
 
 class MachineCodeWidget : public QWidget {
   Q_OBJECT
@@ -17,6 +17,8 @@ class MachineCodeWidget : public QWidget {
 public:
   MachineCodeWidget(BinaryObjectPtr obj, SectionPtr sec);
 
+  void onPatched(SectionPtr sec, int pos, int size);
+
 signals:
   void modified();
 
@@ -26,7 +28,6 @@ protected:
 private:
   void createLayout();
   void setup();
-  void setItemMarked(QTreeWidgetItem *item, int column);
 
   BinaryObjectPtr obj;
   SectionPtr sec;
@@ -34,7 +35,8 @@ private:
 
   bool shown;
   QLabel *label;
-  TreeWidget *treeWidget;
+  TreeView *treeView;
+  MachineCodeModel *model;
 };
 
 #endif // BMOD_MACHINE_CODE_WIDGET_H
@@ -1,7 +1,9 @@
 #include <QDebug>
 #include <QMenuBar>
 #include <QSettings>
+#include <QStatusBar>
 #include <QTabWidget>
+#include <QEventLoop>
 #include <QCloseEvent>
 #include <QVBoxLayout>
 #include <QFileDialog>
@@ -10,15 +12,18 @@
 #include <QProgressDialog>
 
 #include "../Util.h"
+#include "../Backup.h"
 #include "MainWindow.h"
+#include "WidgetUtil.h"
 #include "BinaryWidget.h"
 #include "ConversionHelper.h"
 #include "../formats/Format.h"
+#include "../formats/ParserThread.h"
 #include "PreferencesDialog.h"
 #include "DisassemblerDialog.h"
 
 MainWindow::MainWindow(const QStringList &files)
-  : shown{false}, modified{false}, startupFiles{files}
+  : shown{false}, loading{false}, startupFiles{files}
 {
   // Remove possible duplicates.
   startupFiles = startupFiles.toSet().toList();
@@ -41,7 +46,7 @@ void MainWindow::showEvent(QShowEvent *event) {
 
   if (geometry.isEmpty()) {
     resize(900, 500);
-    Util::centerWidget(this);
+    WidgetUtil::centerWidget(this);
   }
   else {
     restoreGeometry(geometry);
@@ -59,6 +64,16 @@ void MainWindow::showEvent(QShowEvent *event) {
 }
 
 void MainWindow::closeEvent(QCloseEvent *event) {
+  // The parser thread must finish before the window goes away.
+  if (loading) {
+    event->ignore();
+    return;
+  }
+
+  bool modified{false};
+  foreach (const auto *binary, binaryWidgets) {
+    modified = modified || binary->isModified();
+  }
   if (config.getConfirmQuit() && modified) {
     auto answer =
       QMessageBox::question(this, "bmod",
@@ -73,6 +88,8 @@ void MainWindow::closeEvent(QCloseEvent *event) {
 }
 
 void MainWindow::openBinary() {
+  if (loading) return;
+
   QFileDialog diag(this, tr("Open Binary"), QDir::homePath());
   diag.setNameFilters(QStringList{"Mach-O binary (*.o *.dylib *.bundle *)",
                                   "Any file (*)"});
@@ -122,11 +139,15 @@ void MainWindow::saveBinary() {
       backup = (answer == QMessageBox::Yes);
     }
     if (backup) {
-      saveBackup(binary->getFile());
+      saveBackup(binary);
     }
   }
 
-  binary->commit();
+  QString summary;
+  if (!binary->commit(&summary)) {
+    return;
+  }
+  statusBar()->showMessage(summary, 10000);
 
   QString text = tabWidget->tabText(idx);
   if (text.endsWith(" *")) {
@@ -136,6 +157,8 @@ void MainWindow::saveBinary() {
 }
 
 void MainWindow::closeBinary() {
+  if (loading) return;
+
   int idx = tabWidget->currentIndex();
   if (idx != -1) {
     auto answer =
@@ -154,6 +177,60 @@ void MainWindow::closeBinary() {
   }
 }
 
+void MainWindow::undo() {
+  int idx = tabWidget->currentIndex();
+  if (idx != -1) {
+    binaryWidgets[idx]->undo();
+  }
+}
+
+void MainWindow::redo() {
+  int idx = tabWidget->currentIndex();
+  if (idx != -1) {
+    binaryWidgets[idx]->redo();
+  }
+}
+
+void MainWindow::restoreBackup() {
+  int idx = tabWidget->currentIndex();
+  if (idx == -1) {
+    return;
+  }
+
+  QString file = binaryWidgets[idx]->getFile();
+  QFileInfo fi(file);
+  QFileDialog diag(this, tr("Restore Backup"), fi.absolutePath());
+  diag.setNameFilters(QStringList{tr("Backup (%1.bak*)").arg(fi.fileName()),
+                                  "Any file (*)"});
+  if (!diag.exec()) {
+    return;
+  }
+
+  QString backup = diag.selectedFiles().first();
+  auto answer =
+    QMessageBox::question(this, "bmod",
+                          tr("Are you sure you want to restore \"%1\" from "
+                             "\"%2\"? Uncommitted changes will be lost.")
+                          .arg(file).arg(backup));
+  if (answer == QMessageBox::No) {
+    return;
+  }
+
+  QString error;
+  if (!Backup::restore(backup, file, &error)) {
+    QMessageBox::critical(this, "bmod",
+                          tr("Could not restore backup!\n%1").arg(error));
+    return;
+  }
+
+  // Load the restored file again.
+  tabWidget->removeTab(idx);
+  delete binaryWidgets.takeAt(idx);
+  loadBinary(file);
+  statusBar()->showMessage(tr("Restored \"%1\" from \"%2\"")
+                           .arg(file).arg(backup), 10000);
+}
+
 void MainWindow::showPreferences() {
   PreferencesDialog diag(config);
   diag.exec();
@@ -180,12 +257,16 @@ void MainWindow::onBinaryObjectModified() {
   auto *bin = qobject_cast<BinaryWidget*>(sender());
   if (!bin) return;
 
-  modified = true;
-  int idx = tabWidget->currentIndex();
+  // Undoing all patches since the last commit makes it unmodified.
+  int idx = binaryWidgets.indexOf(bin);
   QString text = tabWidget->tabText(idx);
-  if (!text.endsWith(" *")) {
+  if (bin->isModified() && !text.endsWith(" *")) {
     tabWidget->setTabText(idx, text + " *");
   }
+  else if (!bin->isModified() && text.endsWith(" *")) {
+    text.chop(2);
+    tabWidget->setTabText(idx, text);
+  }
 }
 
 void MainWindow::readSettings() {
@@ -237,12 +318,17 @@ void MainWindow::createMenu() {
                       QKeySequence::Save);
   fileMenu->addAction(tr("Close binary"), this, SLOT(closeBinary()),
                       QKeySequence::Close);
+  fileMenu->addAction(tr("Restore backup"), this, SLOT(restoreBackup()));
 #ifndef MAC
   fileMenu->addSeparator();
 #endif
   fileMenu->addAction(tr("Preferences"), this, SLOT(showPreferences()),
                       QKeySequence(Qt::CTRL + Qt::Key_P));
 
+  QMenu *editMenu = menuBar()->addMenu(tr("Edit"));
+  editMenu->addAction(tr("Undo"), this, SLOT(undo()), QKeySequence::Undo);
+  editMenu->addAction(tr("Redo"), this, SLOT(redo()), QKeySequence::Redo);
+
   QMenu *toolsMenu = menuBar()->addMenu(tr("Tools"));
   toolsMenu->addAction(tr("Conversion helper"),
                        this, SLOT(showConversionHelper()),
@@ -253,13 +339,17 @@ void MainWindow::createMenu() {
 }
 
 void MainWindow::loadBinary(QString file) {
+  if (loading) return;
+
   // If .app then resolve the internal binary file.
   QString appBin = Util::resolveAppBinary(file);
   if (!appBin.isEmpty()) {
     file = appBin;
   }
 
+  // Modal so the window can't be used or closed while parsing.
   QProgressDialog progDiag(this);
+  progDiag.setWindowModality(Qt::WindowModal);
   progDiag.setLabelText(tr("Detecting format.."));
   progDiag.setCancelButton(nullptr);
   progDiag.setRange(0, 0);
@@ -274,9 +364,20 @@ void MainWindow::loadBinary(QString file) {
   
   qDebug() << "detected:" << Util::formatTypeString(fmt->getType());
 
+  // Parse on a worker thread so the window stays responsive.
   progDiag.setLabelText(tr("Reading and parsing binary.."));
-  qApp->processEvents();
-  if (!fmt->parse()) {
+  ParserThread thread(fmt);
+  QEventLoop loop;
+  connect(&thread, &QThread::finished, &loop, &QEventLoop::quit);
+  loading = true;
+  thread.start();
+  loop.exec();
+
+  // The loop might have been quit by something else, and waiting also
+  // makes the result of the thread visible here.
+  thread.wait();
+  loading = false;
+  if (!thread.isSuccess()) {
     QMessageBox::warning(this, "bmod", tr("Could not parse file!"));
     return;
   }
@@ -297,23 +398,13 @@ void MainWindow::loadBinary(QString file) {
   tabWidget->setCurrentIndex(idx);
 }
 
-void MainWindow::saveBackup(const QString &file) {
+void MainWindow::saveBackup(const BinaryWidget *binary) {
+  QString file = binary->getFile();
+
   // Determine if prior backups have been made and, if so, how many.
-  QFileInfo fi(file);
-  QDir dir = fi.dir();
-  int bakCount = 0, bakNum = 0;
-  QStringList files;
-  foreach (const auto &entry,
-           dir.entryInfoList(QStringList{QString("%1.bak*").arg(fi.fileName())},
-                             QDir::Files, QDir::Name)) {
-    files << entry.absoluteFilePath();
-    bakCount++;
-    QString ext = entry.suffix();
-    static QRegExp re("bak([\\d]+)$");
-    if (re.indexIn(ext) != -1 && re.captureCount() == 1) {
-      bakNum = re.capturedTexts()[1].toUInt();
-    }
-  }
+  QStringList files = Backup::getBackups(file);
+  int bakCount = files.size();
+  QString dest = Backup::nextFileName(file);
 
   // Remove previous backups if not unlimited. And remove one due to
   // the file that will be created beneath.
@@ -324,10 +415,15 @@ void MainWindow::saveBackup(const QString &file) {
     }
   }
 
-  QString num = Util::padString(QString::number(++bakNum), 4),
-    dest = QString("%1.bak%2").arg(file).arg(num);
-  if (!QFile::copy(file, dest)) {
+  // Only the bytes about to be overwritten are saved unless asked to
+  // copy the whole file.
+  QString error;
+  bool ok = (config.getBackupFullCopy()
+             ? Backup::saveCopy(file, dest, &error)
+             : Backup::saveDelta(file, binary->getObjects(), dest, &error));
+  if (!ok) {
     QMessageBox::warning(this, "bmod",
-                         tr("Could not save backup to \"%1\"!").arg(dest));
+                         tr("Could not save backup to \"%1\"!\n%2")
+                         .arg(dest).arg(error));
   }
 }
@@ -25,6 +25,9 @@ private slots:
   void openBinary();
   void saveBinary();
   void closeBinary();
+  void restoreBackup();
+  void undo();
+  void redo();
   void showPreferences();
   void showConversionHelper();
   void showDisassembler();
@@ -38,10 +41,10 @@ private:
   void createMenu();
 
   void loadBinary(QString file);
-  void saveBackup(const QString &file);
+  void saveBackup(const BinaryWidget *binary);
 
   Config config;
-  bool shown, modified;
+  bool shown, loading;
   QStringList recentFiles, startupFiles;
   QByteArray geometry;
 
@@ -36,6 +36,10 @@ void PreferencesDialog::onBackupAmountChanged(int amount) {
   backupAmountInfo->setVisible(amount == 0);
 }
 
+void PreferencesDialog::onBackupFullCopyChanged(int state) {
+  config.setBackupFullCopy(state == Qt::Checked);
+}
+
 void PreferencesDialog::createLayout() {
   tabWidget = new QTabWidget;
 
@@ -77,7 +81,8 @@ void PreferencesDialog::createTabs() {
   auto *backupLbl =
     new QLabel(tr("Backups are saved in the same folder as the originating "
                   "binary file but with a post-fix of the form \".bakN\", where "
-                  "\"N\" is the backup number."));
+                  "\"N\" is the backup number. Backups can be restored "
+                  "from the File menu."));
   backupLbl->setWordWrap(true);
 
   auto *backupAmountLbl = new QLabel(tr("Number of copies to keep:"));
@@ -103,6 +108,13 @@ void PreferencesDialog::createTabs() {
   connect(backupAskChk, &QCheckBox::stateChanged,
           this, &PreferencesDialog::onBackupAskChanged);
 
+  auto *backupFullChk =
+    new QCheckBox(tr("Save full copies instead of only the bytes being "
+                     "overwritten."));
+  backupFullChk->setChecked(config.getBackupFullCopy());
+  connect(backupFullChk, &QCheckBox::stateChanged,
+          this, &PreferencesDialog::onBackupFullCopyChanged);
+
   /*
   auto *backupCustomChk =
     new QCheckBox(tr("Set custom output folder."));
@@ -112,6 +124,7 @@ void PreferencesDialog::createTabs() {
   backupLayout->addWidget(backupLbl);
   backupLayout->addLayout(backupAmountLayout);
   backupLayout->addWidget(backupAskChk);
+  backupLayout->addWidget(backupFullChk);
   //backupLayout->addWidget(backupCustomChk);
   backupLayout->addStretch();
   backupWidget->setLayout(backupLayout);
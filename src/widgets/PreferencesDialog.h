@@ -19,6 +19,7 @@ private slots:
   void onBackupsToggled(bool on);
   void onBackupAskChanged(int state);
   void onBackupAmountChanged(int amount);
+  void onBackupFullCopyChanged(int state);
 
 private:
   void createLayout();
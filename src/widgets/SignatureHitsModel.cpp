@@ -0,0 +1,88 @@
+#include "../Util.h"
+#include "SignatureHitsModel.h"
+
+SignatureHitsModel::SignatureHitsModel(QObject *parent)
+  : QAbstractTableModel(parent)
+{ }
+
+int SignatureHitsModel::rowCount(const QModelIndex &parent) const {
+  if (parent.isValid()) return 0;
+  return hits.size();
+}
+
+int SignatureHitsModel::columnCount(const QModelIndex &parent) const {
+  if (parent.isValid()) return 0;
+  return 5;
+}
+
+QVariant SignatureHitsModel::data(const QModelIndex &index, int role) const {
+  if (!index.isValid() || role != Qt::DisplayRole) {
+    return QVariant();
+  }
+
+  int row = index.row();
+  if (row < 0 || row >= hits.size()) {
+    return QVariant();
+  }
+
+  const auto &hit = hits[row];
+  switch (index.column()) {
+  case 0:
+    return Util::cpuTypeString(hit.object->getCpuType());
+
+  case 1:
+    return hit.section->getName();
+
+  case 2: {
+    quint64 addr = hit.section->getAddress() + hit.offset;
+    int padSize = hit.object->getSystemBits() / 8;
+    return Util::padString(QString::number(addr, 16).toUpper(), padSize);
+  }
+
+  case 3:
+    return QString::number(hit.offset, 16).toUpper();
+
+  case 4:
+    return names.value(hit.signature);
+  }
+  return QVariant();
+}
+
+QVariant SignatureHitsModel::headerData(int section,
+                                        Qt::Orientation orientation,
+                                        int role) const {
+  if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+    return QVariant();
+  }
+
+  switch (section) {
+  case 0: return tr("Object");
+  case 1: return tr("Section");
+  case 2: return tr("Address");
+  case 3: return tr("Offset");
+  case 4: return tr("Signature");
+  }
+  return QVariant();
+}
+
+Qt::ItemFlags SignatureHitsModel::flags(const QModelIndex &index) const {
+  if (!index.isValid()) {
+    return Qt::NoItemFlags;
+  }
+  return Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+}
+
+void SignatureHitsModel::clear(const QStringList &names) {
+  beginResetModel();
+  this->names = names;
+  hits.clear();
+  endResetModel();
+}
+
+void SignatureHitsModel::appendHits(const SignatureHits &hits) {
+  if (hits.isEmpty()) return;
+  int first = this->hits.size();
+  beginInsertRows(QModelIndex(), first, first + hits.size() - 1);
+  this->hits << hits;
+  endInsertRows();
+}
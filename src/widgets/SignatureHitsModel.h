@@ -0,0 +1,39 @@
+#ifndef BMOD_SIGNATURE_HITS_MODEL_H
+#define BMOD_SIGNATURE_HITS_MODEL_H
+
+#include <QStringList>
+#include <QAbstractTableModel>
+
+#include "../SignatureScanner.h"
+
+/**
+ * Hits of a signature scan as object, section, address, offset and
+ * signature columns. Only the hits are kept, and the text of a row is
+ * produced when the view asks for it.
+ */
+class SignatureHitsModel : public QAbstractTableModel {
+  Q_OBJECT
+
+public:
+  SignatureHitsModel(QObject *parent = nullptr);
+
+  int rowCount(const QModelIndex &parent = QModelIndex()) const;
+  int columnCount(const QModelIndex &parent = QModelIndex()) const;
+
+  QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+
+  QVariant headerData(int section, Qt::Orientation orientation,
+                      int role = Qt::DisplayRole) const;
+  Qt::ItemFlags flags(const QModelIndex &index) const;
+
+  // Remove all hits and name the signatures for the next ones.
+  void clear(const QStringList &names = QStringList());
+
+  void appendHits(const SignatureHits &hits);
+
+private:
+  QStringList names;
+  SignatureHits hits;
+};
+
+#endif // BMOD_SIGNATURE_HITS_MODEL_H
@@ -0,0 +1,189 @@
+#include <QFont>
+#include <QBrush>
+
+#include <algorithm>
+
+#include "../Util.h"
+#include "StringsModel.h"
+
+StringsModel::StringsModel(BinaryObjectPtr obj, SectionPtr sec,
+                           QObject *parent)
+  : QAbstractTableModel(parent), obj{obj}, sec{sec},
+  addrLen{obj->getSystemBits() / 8}, editable{false}
+{ }
+
+int StringsModel::rowCount(const QModelIndex &parent) const {
+  if (parent.isValid()) return 0;
+  return spans.size();
+}
+
+int StringsModel::columnCount(const QModelIndex &parent) const {
+  if (parent.isValid()) return 0;
+  return 4;
+}
+
+QVariant StringsModel::data(const QModelIndex &index, int role) const {
+  if (!index.isValid()) {
+    return QVariant();
+  }
+
+  int row = index.row(), col = index.column();
+  if (row < 0 || row >= spans.size()) {
+    return QVariant();
+  }
+
+  switch (role) {
+  case Qt::DisplayRole:
+  case Qt::EditRole: {
+    const auto &span = spans[row];
+    if (col == 0) {
+      quint64 addr = sec->getAddress() + span.offset;
+      return Util::padString(QString::number(addr, 16).toUpper(), addrLen);
+    }
+
+    QByteArray bytes = getBytes(row);
+    switch (col) {
+    case 1:
+      return StringScanner::toString(bytes, span.encoding);
+
+    case 2:
+      return StringScanner::getLength(bytes, span.encoding);
+
+    case 3:
+      return Util::dataToHex(bytes, 0, bytes.size(), false);
+    }
+    break;
+  }
+
+  case Qt::FontRole:
+    if (col == 3 && isMarked(row)) {
+      QFont font("Courier");
+      font.setBold(true);
+      return font;
+    }
+    break;
+
+  case Qt::ForegroundRole:
+    if (col == 3 && isMarked(row)) {
+      return QBrush(Qt::red);
+    }
+    break;
+  }
+
+  return QVariant();
+}
+
+bool StringsModel::setData(const QModelIndex &index, const QVariant &value,
+                           int role) {
+  if (!index.isValid() || role != Qt::EditRole || index.column() != 3) {
+    return false;
+  }
+
+  int row = index.row();
+  QByteArray data = Util::hexToData(value.toString());
+  if (data.isEmpty() || data.size() != getBytes(row).size() ||
+      !obj->getJournal().write(sec, data, spans[row].offset)) {
+    return false;
+  }
+
+  emit dataChanged(this->index(row, 1), this->index(row, 3));
+  return true;
+}
+
+QVariant StringsModel::headerData(int section, Qt::Orientation orientation,
+                                  int role) const {
+  if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+    return QVariant();
+  }
+
+  switch (section) {
+  case 0: return tr("Address");
+  case 1: return tr("String");
+  case 2: return tr("Length");
+  case 3: return tr("Data");
+  }
+  return QVariant();
+}
+
+Qt::ItemFlags StringsModel::flags(const QModelIndex &index) const {
+  if (!index.isValid()) {
+    return Qt::NoItemFlags;
+  }
+  Qt::ItemFlags res = Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+  if (editable && index.column() == 3) {
+    res |= Qt::ItemIsEditable;
+  }
+  return res;
+}
+
+void StringsModel::setSpans(const StringScanner::Spans &spans,
+                            bool editable) {
+  beginResetModel();
+  this->spans = spans;
+  this->editable = editable;
+  endResetModel();
+}
+
+void StringsModel::replaceSpans(quint32 start, quint32 end,
+                                const StringScanner::Spans &spans) {
+  auto before = [](const StringScanner::Span &span, quint32 offset) {
+    return span.offset < offset;
+  };
+  int row = std::lower_bound(this->spans.constBegin(), this->spans.constEnd(),
+                             start, before) - this->spans.constBegin();
+  int last = std::lower_bound(this->spans.constBegin(), this->spans.constEnd(),
+                              end, before) - this->spans.constBegin();
+
+  // Update the rows in place as far as possible, and insert or remove
+  // the rest.
+  int oldCount = last - row, newCount = spans.size(),
+    common = qMin(oldCount, newCount);
+  for (int i = 0; i < common; i++) {
+    this->spans[row + i] = spans[i];
+  }
+  if (common > 0) {
+    emit dataChanged(index(row, 0), index(row + common - 1, 3));
+  }
+
+  if (newCount > oldCount) {
+    beginInsertRows(QModelIndex(), row + common, row + newCount - 1);
+    this->spans.insert(row + common, newCount - common, spans[common]);
+    for (int i = common + 1; i < newCount; i++) {
+      this->spans[row + i] = spans[i];
+    }
+    endInsertRows();
+  }
+  else if (oldCount > newCount) {
+    beginRemoveRows(QModelIndex(), row + common, row + oldCount - 1);
+    this->spans.remove(row + common, oldCount - common);
+    endRemoveRows();
+  }
+}
+
+int StringsModel::getRow(quint32 offset) const {
+  // Last string starting at or before the offset.
+  auto it = std::upper_bound(spans.constBegin(), spans.constEnd(), offset,
+                             [](quint32 offset,
+                                const StringScanner::Span &span) {
+                               return offset < span.offset;
+                             });
+  if (it == spans.constBegin()) {
+    return -1;
+  }
+  --it;
+  if (offset >= it->offset + it->length) {
+    return -1;
+  }
+  return it - spans.constBegin();
+}
+
+QByteArray StringsModel::getBytes(int row) const {
+  const auto &span = spans[row];
+  return sec->read(span.offset, span.length);
+}
+
+bool StringsModel::isMarked(int row) const {
+  const auto &span = spans[row];
+  return sec->getModifiedRegions().intersects(span.offset,
+                                              span.offset + span.length);
+}
@@ -0,0 +1,59 @@
+#ifndef BMOD_STRINGS_MODEL_H
+#define BMOD_STRINGS_MODEL_H
+
+#include <QAbstractTableModel>
+
+#include "../Section.h"
+#include "../BinaryObject.h"
+#include "../StringScanner.h"
+
+/**
+ * Strings of a section as address, string, length and data columns.
+ * Only the spans of the strings are kept, and the text of a row is
+ * decoded from the section data when the view asks for it.
+ */
+class StringsModel : public QAbstractTableModel {
+  Q_OBJECT
+
+public:
+  StringsModel(BinaryObjectPtr obj, SectionPtr sec, QObject *parent = nullptr);
+
+  int rowCount(const QModelIndex &parent = QModelIndex()) const;
+  int columnCount(const QModelIndex &parent = QModelIndex()) const;
+
+  QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+  bool setData(const QModelIndex &index, const QVariant &value,
+               int role = Qt::EditRole);
+
+  QVariant headerData(int section, Qt::Orientation orientation,
+                      int role = Qt::DisplayRole) const;
+  Qt::ItemFlags flags(const QModelIndex &index) const;
+
+  /**
+   * Show the spans. The data of NUL-terminated strings can be edited
+   * if editable.
+   */
+  void setSpans(const StringScanner::Spans &spans, bool editable);
+
+  /**
+   * Replace the spans starting in [start, end) of the section with
+   * spans, which must lie in it too, and only update their rows.
+   */
+  void replaceSpans(quint32 start, quint32 end,
+                    const StringScanner::Spans &spans);
+
+  // Row of the string containing the byte at offset, or -1.
+  int getRow(quint32 offset) const;
+
+private:
+  QByteArray getBytes(int row) const;
+  bool isMarked(int row) const;
+
+  BinaryObjectPtr obj;
+  SectionPtr sec;
+  int addrLen;
+  StringScanner::Spans spans;
+  bool editable;
+};
+
+#endif // BMOD_STRINGS_MODEL_H
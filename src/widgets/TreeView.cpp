@@ -0,0 +1,26 @@
+#include "TreeView.h"
+
+TreeView::TreeView(QWidget *parent) : QTreeView(parent) {
+  helper = new TreeViewHelper(this);
+
+  // Flat list of rows of equal height so the view never has to query
+  // rows that aren't visible.
+  setRootIsDecorated(false);
+  setItemsExpandable(false);
+  setUniformRowHeights(true);
+}
+
+void TreeView::setModel(QAbstractItemModel *model) {
+  QTreeView::setModel(model);
+  helper->setModel(model);
+}
+
+void TreeView::keyPressEvent(QKeyEvent *event) {
+  QTreeView::keyPressEvent(event);
+  helper->keyPressEvent(event);
+}
+
+void TreeView::resizeEvent(QResizeEvent *event) {
+  QTreeView::resizeEvent(event);
+  helper->resizeEvent();
+}
@@ -0,0 +1,43 @@
+#ifndef BMOD_TREE_VIEW_H
+#define BMOD_TREE_VIEW_H
+
+#include <QTreeView>
+
+#include "TreeViewHelper.h"
+
+/**
+ * Model-based counterpart of TreeWidget for views with a large number
+ * of rows. The model is expected to produce its data on demand, and
+ * the view assumes uniform row heights so only the visible rows are
+ * ever queried.
+ */
+class TreeView : public QTreeView {
+  Q_OBJECT
+
+public:
+  TreeView(QWidget *parent = nullptr);
+
+  void setModel(QAbstractItemModel *model);
+
+  void setCpuType(CpuType type) { helper->setCpuType(type); }
+  void setMachineCodeColumns(const QList<int> columns) {
+    helper->setMachineCodeColumns(columns);
+  }
+
+  void setAddressColumn(int column) { helper->setAddressColumn(column); }
+
+  // See TreeViewHelper::setSection().
+  void setSection(BinaryObjectPtr obj, SectionPtr sec, SearchQuery::Kind def,
+                  TreeViewHelper::RowFunc rowFunc, int column) {
+    helper->setSection(obj, sec, def, rowFunc, column);
+  }
+
+protected:
+  void keyPressEvent(QKeyEvent *event);
+  void resizeEvent(QResizeEvent *event);
+
+private:
+  TreeViewHelper *helper;
+};
+
+#endif // BMOD_TREE_VIEW_H
@@ -0,0 +1,603 @@
+#include <QMenu>
+#include <QDebug>
+#include <QLabel>
+#include <QKeyEvent>
+#include <QClipboard>
+#include <QMessageBox>
+#include <QTreeView>
+#include <QApplication>
+#include <QInputDialog>
+
+#include <algorithm>
+
+#include "LineEdit.h"
+#include "TreeViewHelper.h"
+#include "DisassemblerDialog.h"
+#include "../SearchThread.h"
+
+TreeViewHelper::TreeViewHelper(QTreeView *view)
+  : QObject(view), view{view}, cpuType{CpuType::X86}, addrColumn{-1},
+  curCol{0}, curItem{0}, cur{0}, total{0},
+  searchKind{SearchQuery::Kind::Ascii}, searchColumn{0}, searchPerc{0},
+  searchThread{nullptr}
+{
+  view->setSelectionBehavior(QAbstractItemView::SelectItems);
+  view->setSelectionMode(QAbstractItemView::SingleSelection);
+  view->setEditTriggers(QAbstractItemView::DoubleClicked);
+  view->setContextMenuPolicy(Qt::CustomContextMenu);
+  connect(view, &QTreeView::customContextMenuRequested,
+          this, &TreeViewHelper::onShowContextMenu);
+
+  // Set fixed-width font.
+  view->setFont(QFont("Courier"));
+
+  searchEdit = new LineEdit(view);
+  searchEdit->setVisible(false);
+  searchEdit->setFixedWidth(150);
+  searchEdit->setFixedHeight(21);
+  searchEdit->setPlaceholderText(tr("Search query"));
+  connect(searchEdit, &LineEdit::focusLost,
+          this, &TreeViewHelper::onSearchLostFocus);
+  connect(searchEdit, &LineEdit::keyDown,
+          this, &TreeViewHelper::nextSearchResult);
+  connect(searchEdit, &LineEdit::keyUp,
+          this, &TreeViewHelper::prevSearchResult);
+  connect(searchEdit, &LineEdit::returnPressed,
+          this, &TreeViewHelper::onSearchReturnPressed);
+  connect(searchEdit, &LineEdit::textEdited,
+          this, &TreeViewHelper::onSearchEdited);
+
+  searchLabel = new QLabel(view);
+  searchLabel->setVisible(false);
+  searchLabel->setAlignment(Qt::AlignRight | Qt::AlignVCenter);
+  searchLabel->setFixedHeight(searchEdit->height());
+  searchLabel->setStyleSheet("QLabel { "
+                               "background-color: #EEEEEE; "
+                               "border-top: 1px solid #CCCCCC; "
+                             "}");
+}
+
+TreeViewHelper::~TreeViewHelper() {
+  stopSearch();
+}
+
+void TreeViewHelper::setModel(QAbstractItemModel *model) {
+  if (this->model) {
+    disconnect(this->model, nullptr, this, nullptr);
+  }
+  this->model = model;
+  clearAddressIndex();
+  if (!model) return;
+
+  // The address index is built again when needed.
+  connect(model, &QAbstractItemModel::rowsInserted,
+          this, &TreeViewHelper::clearAddressIndex);
+
+  // Hits in rows that weren't there yet might be shown now.
+  connect(model, &QAbstractItemModel::rowsInserted,
+          this, &TreeViewHelper::onRowsInserted);
+  connect(model, &QAbstractItemModel::rowsRemoved,
+          this, &TreeViewHelper::clearAddressIndex);
+  connect(model, &QAbstractItemModel::modelReset,
+          this, &TreeViewHelper::clearAddressIndex);
+  connect(model, &QAbstractItemModel::dataChanged,
+          this, &TreeViewHelper::clearAddressIndex);
+}
+
+void TreeViewHelper::setMachineCodeColumns(const QList<int> columns) {
+  if (columns.isEmpty()) {
+    machineCodeColumns.clear();
+    return;
+  }
+
+  int cols = columnCount();
+  foreach (int col, columns) {
+    if (col < cols) {
+      machineCodeColumns << col;
+    }
+  }
+  machineCodeColumns = machineCodeColumns.toSet().toList();
+  if (machineCodeColumns.size() > cols) {
+    machineCodeColumns.clear();
+  }
+}
+
+void TreeViewHelper::setAddressColumn(int column) {
+  if (column < 0 || column > columnCount() - 1) {
+    addrColumn = -1;
+    return;
+  }
+
+  addrColumn = column;
+}
+
+void TreeViewHelper::setSection(BinaryObjectPtr obj, SectionPtr sec,
+                                SearchQuery::Kind def, RowFunc rowFunc,
+                                int column) {
+  resetSearch();
+  sectionObj = obj;
+  section = sec;
+  searchKind = def;
+  this->rowFunc = rowFunc;
+  searchColumn = column;
+}
+
+void TreeViewHelper::keyPressEvent(QKeyEvent *event) {
+  bool ctrl{false};
+#ifdef MAC
+  ctrl = event->modifiers() | Qt::MetaModifier;
+#else
+  ctrl = event->modifiers() | Qt::ControlModifier;
+#endif
+  if (ctrl && event->key() == Qt::Key_F) {
+    doSearch();
+  }
+  else if (event->key() == Qt::Key_Escape) {
+    endSearch();
+  }
+}
+
+void TreeViewHelper::resizeEvent() {
+  if (searchEdit->isVisible()) {
+    searchEdit->move(view->width() - searchEdit->width() - 1,
+                     view->height() - searchEdit->height() - 1);
+    searchLabel->setFixedWidth(view->width() - searchEdit->width());
+    searchLabel->move(1, searchEdit->pos().y());
+  }
+}
+
+void TreeViewHelper::endSearch() {
+  stopSearch();
+  pendingHits.clear();
+  searchEdit->hide();
+  searchLabel->hide();
+  searchEdit->clear();
+  searchLabel->clear();
+  view->setFocus();
+}
+
+void TreeViewHelper::onShowContextMenu(const QPoint &pos) {
+  QMenu menu;
+  menu.addAction("Search", this, SLOT(doSearch()));
+
+  if (addrColumn != -1) {
+    menu.addAction("Find address", this, SLOT(findAddress()));
+  }
+
+  ctxIndex = view->indexAt(pos);
+  if (ctxIndex.isValid()) {
+    menu.addSeparator();
+    menu.addAction("Copy field", this, SLOT(copyField()));
+    menu.addAction("Copy row", this, SLOT(copyRow()));
+
+    if (machineCodeColumns.contains(ctxIndex.column())) {
+      menu.addSeparator();
+      menu.addAction("Disassemble", this, SLOT(disassemble()));
+    }
+  }
+
+  // Use cursor because mapToGlobal(pos) is off by the height of the
+  // tree view header anyway.
+  menu.exec(QCursor::pos());
+
+  ctxIndex = QModelIndex();
+}
+
+void TreeViewHelper::doSearch() {
+  searchEdit->move(view->width() - searchEdit->width() - 1,
+                   view->height() - searchEdit->height() - 1);
+  searchEdit->show();
+  searchEdit->setFocus();
+}
+
+void TreeViewHelper::disassemble() {
+  if (!ctxIndex.isValid()) return;
+  QString text = ctxIndex.data().toString();
+  quint64 offset{0};
+  if (addrColumn != -1) {
+    bool ok;
+    offset = ctxIndex.sibling(ctxIndex.row(), addrColumn).data().toString()
+      .toULongLong(&ok, 16);
+    if (!ok) offset = 0;
+  }
+  DisassemblerDialog diag(view, cpuType, text, offset);
+  diag.exec();
+}
+
+void TreeViewHelper::copyField() {
+  if (!ctxIndex.isValid()) return;
+  QString text = ctxIndex.data().toString();
+  QApplication::clipboard()->setText(text);
+}
+
+void TreeViewHelper::copyRow() {
+  if (!ctxIndex.isValid()) return;
+  QString text;
+  int cols = columnCount();
+  for (int i = 0; i < cols; i++) {
+    text += ctxIndex.sibling(ctxIndex.row(), i).data().toString();
+    if (i < cols - 1) {
+      text += "\t";
+    }
+  }
+  QApplication::clipboard()->setText(text);
+}
+
+void TreeViewHelper::findAddress() {
+  bool ok;
+  QString text =
+    QInputDialog::getText(view, tr("Find Address"), tr("Address (hex):"),
+                          QLineEdit::Normal, QString(), &ok);
+  if (!ok || text.isEmpty()) {
+    return;
+  }
+
+  quint64 num = text.toULongLong(&ok, 16);
+  if (!ok) {
+    QMessageBox::warning(view, "bmod",
+                         tr("Invalid address! Must be in hexadecimal."));
+    findAddress();
+    return;
+  }
+
+  int row = findAddressRow(num);
+  if (row != -1) {
+    auto index = model->index(row, addrColumn);
+    view->setCurrentIndex(index);
+    view->scrollTo(index, QAbstractItemView::PositionAtCenter);
+    return;
+  }
+
+  QMessageBox::information(view, "bmod", tr("Did not find anything."));
+}
+
+int TreeViewHelper::columnCount() const {
+  return (model ? model->columnCount() : 0);
+}
+
+void TreeViewHelper::resetSearch() {
+  stopSearch();
+  searchEdit->clear();
+  searchLabel->clear();
+  searchLabel->hide();
+  searchResults.clear();
+  hitOffsets.clear();
+  pendingHits.clear();
+  lastQuery.clear();
+  curCol = curItem = cur = total = 0;
+}
+
+void TreeViewHelper::onSearchLostFocus() {
+  if (searchEdit->isVisible() && searchEdit->text().isEmpty()) {
+    endSearch();
+  }
+}
+
+void TreeViewHelper::onSearchReturnPressed() {
+  QString query = searchEdit->text().trimmed();
+  if (query.isEmpty()) {
+    resetSearch();
+    return;
+  }
+
+  if (query == lastQuery) {
+    nextSearchResult();
+    return;
+  }
+
+  if (section) {
+    startSearch(query);
+    return;
+  }
+
+  if (!model) return;
+
+  int cols = columnCount();
+  searchResults.clear();
+  total = 0;
+  for (int col = 0; col < cols; col++) {
+    auto res = model->match(model->index(0, col), Qt::DisplayRole, query,
+                            -1, Qt::MatchContains);
+    if (!res.isEmpty()) {
+      auto &list = searchResults[col];
+      foreach (const auto &index, res) {
+        list << index;
+      }
+      total += res.size();
+    }
+  }
+
+  if (searchResults.isEmpty()) {
+    showSearchText(tr("No matches found"));
+    return;
+  }
+
+  lastQuery = query;
+  cur = 0;
+  curCol = searchResults.keys().first();
+  curItem = 0;
+  selectSearchResult(curCol, curItem);
+}
+
+void TreeViewHelper::selectSearchResult(int col, int item) {
+  QModelIndex index = getResult(col, item);
+  if (!index.isValid()) {
+    return;
+  }
+
+  showSearchStatus();
+
+  // Select entry and not entire row.
+  view->scrollTo(index, QAbstractItemView::PositionAtCenter);
+  view->selectionModel()->setCurrentIndex(index,
+                                          QItemSelectionModel::SelectCurrent);
+}
+
+void TreeViewHelper::nextSearchResult() {
+  if (total == 0) return;
+  int pos = curItem;
+  pos++;
+  if (pos > getResultCount(curCol) - 1) {
+    curItem = 0;
+    const auto keys = getResultColumns();
+    int pos2 = keys.indexOf(curCol);
+    pos2++;
+    if (pos2 > keys.size() - 1) {
+      curCol = keys[0];
+    }
+    else {
+      curCol = keys[pos2];
+    }
+  }
+  else {
+    curItem = pos;
+  }
+
+  cur++;
+  if (cur > total - 1) {
+    cur = 0;
+  }
+
+  selectSearchResult(curCol, curItem);
+}
+
+void TreeViewHelper::prevSearchResult() {
+  if (total == 0) return;
+  int pos = curItem;
+  pos--;
+  if (pos < 0) {
+    const auto keys = getResultColumns();
+    int pos2 = keys.indexOf(curCol);
+    pos2--;
+    if (pos2 < 0) {
+      curCol = keys.last();
+    }
+    else {
+      curCol = keys[pos2];
+    }
+    curItem = getResultCount(curCol) - 1;
+  }
+  else {
+    curItem = pos;
+  }
+
+  cur--;
+  if (cur < 0) {
+    cur = total - 1;
+  }
+
+  selectSearchResult(curCol, curItem);
+}
+
+void TreeViewHelper::onSearchEdited(const QString &text) {
+  // If search was performed or no results were found then hide search
+  // label when editing the field.
+  if (!lastQuery.isEmpty() || total == 0) {
+    searchLabel->clear();
+    searchLabel->hide();
+  }
+}
+
+void TreeViewHelper::showSearchText(const QString &text) {
+  searchLabel->setText(text + "    ");
+  searchLabel->setFixedWidth(view->width() - searchEdit->width());
+  searchLabel->move(1, searchEdit->pos().y());
+  searchLabel->show();
+}
+
+void TreeViewHelper::startSearch(const QString &text) {
+  stopSearch();
+  searchResults.clear();
+  hitOffsets.clear();
+  pendingHits.clear();
+  curCol = searchColumn;
+  curItem = cur = total = searchPerc = 0;
+
+  SearchQuery query;
+  QString error;
+  if (!SearchQuery::parse(text, searchKind, query, &error)) {
+    lastQuery.clear();
+    showSearchText(error);
+    return;
+  }
+
+  // Hits come in batches and the first one is selected right away.
+  lastQuery = text;
+  searchThread = new SearchThread(sectionObj, section, query, this);
+  connect(searchThread, &SearchThread::hits,
+          this, &TreeViewHelper::onSearchHits);
+  connect(searchThread, &QThread::finished,
+          this, &TreeViewHelper::onSearchFinished);
+  showSearchStatus();
+  searchThread->start();
+}
+
+void TreeViewHelper::stopSearch() {
+  if (!searchThread) return;
+  searchThread->stop();
+  searchThread = nullptr;
+}
+
+void TreeViewHelper::onSearchHits(const SearchHits &hits, qint64 pos,
+                                  qint64 size) {
+  if (sender() != searchThread || searchThread->isCancelled()) {
+    return;
+  }
+
+  bool first = (total == 0);
+  retryHits();
+  addHits(hits);
+
+  searchPerc = (size > 0 ? (long double) pos / (long double) size * 100.0
+                : 100);
+  if (first && total > 0) {
+    selectSearchResult(curCol, curItem);
+  }
+  else {
+    showSearchStatus();
+  }
+}
+
+void TreeViewHelper::onRowsInserted() {
+  if (pendingHits.isEmpty()) {
+    return;
+  }
+
+  bool first = (total == 0);
+  retryHits();
+  if (first && total > 0) {
+    selectSearchResult(curCol, curItem);
+  }
+  else if (total > 0) {
+    showSearchStatus();
+  }
+}
+
+void TreeViewHelper::addHits(const SearchHits &hits) {
+  // Rows might be inserted and removed above later hits, so only their
+  // offsets are kept and they are looked up when selected.
+  foreach (const auto &hit, hits) {
+    // Hits within the same row are shown once, and hits in rows that
+    // aren't there yet are kept until they are.
+    int row = rowFunc(hit.offset);
+    if (row == -1) {
+      pendingHits << hit;
+      continue;
+    }
+    if (!hitOffsets.isEmpty() && rowFunc(hitOffsets.last()) == row) {
+      continue;
+    }
+    hitOffsets << hit.offset;
+    total++;
+  }
+}
+
+void TreeViewHelper::retryHits() {
+  // Rows are added in the order of the data, so the first hit that
+  // still has no row means the rest don't either.
+  int cnt{0};
+  for (; cnt < pendingHits.size(); cnt++) {
+    if (rowFunc(pendingHits[cnt].offset) == -1) break;
+  }
+  if (cnt == 0) return;
+
+  SearchHits hits = pendingHits.mid(0, cnt);
+  pendingHits.remove(0, cnt);
+  addHits(hits);
+}
+
+void TreeViewHelper::onSearchFinished() {
+  if (sender() != searchThread) {
+    return;
+  }
+
+  searchThread->deleteLater();
+  searchThread = nullptr;
+  showSearchStatus();
+}
+
+void TreeViewHelper::showSearchStatus() {
+  QString text;
+  if (total > 0) {
+    text = tr("%1 of %2 matches").arg(cur + 1).arg(total);
+  }
+  else if (!searchThread) {
+    text = tr("No matches found");
+  }
+
+  if (searchThread) {
+    QString perc = tr("searching.. %1%").arg(searchPerc);
+    text = (text.isEmpty() ? perc : text + ", " + perc);
+  }
+  showSearchText(text);
+}
+
+QList<int> TreeViewHelper::getResultColumns() const {
+  if (section) {
+    return (hitOffsets.isEmpty() ? QList<int>() : QList<int>{searchColumn});
+  }
+  return searchResults.keys();
+}
+
+int TreeViewHelper::getResultCount(int col) const {
+  if (section) {
+    return (col == searchColumn ? hitOffsets.size() : 0);
+  }
+  return searchResults.value(col).size();
+}
+
+QModelIndex TreeViewHelper::getResult(int col, int item) const {
+  if (item < 0 || item >= getResultCount(col) || !model) {
+    return QModelIndex();
+  }
+  if (section) {
+    return model->index(rowFunc(hitOffsets[item]), col);
+  }
+  return searchResults[col][item];
+}
+
+int TreeViewHelper::findAddressRow(quint64 addr) {
+  if (section && rowFunc) {
+    quint64 start = section->getAddress();
+    if (addr < start || addr - start >= quint64(section->getDataSize())) {
+      return -1;
+    }
+    return rowFunc(addr - start);
+  }
+
+  // Index the address column once until the rows change.
+  if (addrIndex.isEmpty()) {
+    bool ok;
+    int cnt = (model ? model->rowCount() : 0);
+    for (int i = 0; i < cnt; i++) {
+      quint64 n = model->index(i, addrColumn).data().toString()
+        .toULongLong(&ok, 16);
+      if (ok) addrIndex << qMakePair(n, i);
+    }
+    std::stable_sort(addrIndex.begin(), addrIndex.end(),
+                     [](const QPair<quint64, int> &a,
+                        const QPair<quint64, int> &b) {
+                       return a.first < b.first;
+                     });
+  }
+
+  // Row of the last address at or before addr, which contains it unless
+  // it is the last row.
+  auto it = std::upper_bound(addrIndex.constBegin(), addrIndex.constEnd(),
+                             addr, [](quint64 value,
+                                      const QPair<quint64, int> &entry) {
+                               return value < entry.first;
+                             });
+  if (it == addrIndex.constBegin()) {
+    return -1;
+  }
+  --it;
+  if (it->first != addr && it + 1 == addrIndex.constEnd()) {
+    return -1;
+  }
+  return it->second;
+}
+
+void TreeViewHelper::clearAddressIndex() {
+  addrIndex.clear();
+}
@@ -0,0 +1,141 @@
+#ifndef BMOD_TREE_VIEW_HELPER_H
+#define BMOD_TREE_VIEW_HELPER_H
+
+#include <QMap>
+#include <QList>
+#include <QPair>
+#include <QObject>
+#include <QVector>
+#include <QPointer>
+#include <QModelIndex>
+#include <QPersistentModelIndex>
+
+#include <functional>
+
+#include "../Section.h"
+#include "../CpuType.h"
+#include "../Searcher.h"
+#include "../SearchQuery.h"
+#include "../BinaryObject.h"
+
+class QLabel;
+class QKeyEvent;
+class QTreeView;
+class LineEdit;
+class SearchThread;
+class QAbstractItemModel;
+
+/**
+ * Context menu, copying, finding addresses and searching shared by
+ * TreeWidget and TreeView. It only goes through the model of the view
+ * so it works the same for items and models.
+ */
+class TreeViewHelper : public QObject {
+  Q_OBJECT
+
+public:
+  // Row of the data at offset of the section, or -1 if not shown.
+  typedef std::function<int(quint32 offset)> RowFunc;
+
+  TreeViewHelper(QTreeView *view);
+  ~TreeViewHelper();
+
+  // Must be called when the view gets a new model.
+  void setModel(QAbstractItemModel *model);
+
+  void setCpuType(CpuType type) { cpuType = type; }
+  void setMachineCodeColumns(const QList<int> columns);
+
+  void setAddressColumn(int column);
+
+  /**
+   * Rows show the data of the section, and rowFunc gives the row of an
+   * offset into it. Addresses are then found without looking at the
+   * rows, and the data is searched on a worker thread instead of the
+   * text of the rows. Queries without a prefix are of kind def, see
+   * SearchQuery, and hits are shown in column.
+   */
+  void setSection(BinaryObjectPtr obj, SectionPtr sec,
+                  SearchQuery::Kind def, RowFunc rowFunc, int column);
+
+  // Called from the events of the view after its own handling.
+  void keyPressEvent(QKeyEvent *event);
+  void resizeEvent();
+
+private slots:
+  void doSearch();
+  void endSearch();
+  void onSearchLostFocus();
+  void onSearchReturnPressed();
+  void nextSearchResult();
+  void prevSearchResult();
+  void onSearchEdited(const QString &text);
+  void onSearchHits(const SearchHits &hits, qint64 pos, qint64 size);
+  void onSearchFinished();
+  void onRowsInserted();
+  void onShowContextMenu(const QPoint &pos);
+  void disassemble();
+  void copyField();
+  void copyRow();
+  void findAddress();
+  void clearAddressIndex();
+
+private:
+  int columnCount() const;
+  void resetSearch();
+
+  /**
+   * Row showing the address, or -1. Uses the row function of the
+   * section if set or else a sorted index of the address column.
+   */
+  int findAddressRow(quint64 addr);
+
+  void startSearch(const QString &query);
+  void stopSearch();
+
+  // Show the hits in their rows, or keep them for later if not there.
+  void addHits(const SearchHits &hits);
+
+  // Show the kept hits whose rows were added since.
+  void retryHits();
+
+  // Columns with results, their number and the index of one.
+  QList<int> getResultColumns() const;
+  int getResultCount(int col) const;
+  QModelIndex getResult(int col, int item) const;
+
+  void selectSearchResult(int col, int item);
+  void showSearchText(const QString &text);
+  void showSearchStatus();
+
+  QTreeView *view;
+  QPointer<QAbstractItemModel> model;
+
+  QList<int> machineCodeColumns;
+  CpuType cpuType;
+  QModelIndex ctxIndex;
+  int addrColumn;
+
+  // Addresses of the address column and their rows, sorted.
+  QVector<QPair<quint64, int>> addrIndex;
+
+  // Matches of the text of the rows by column, or the offsets of the
+  // hits, one per row, when searching the section.
+  QMap<int, QList<QPersistentModelIndex>> searchResults;
+  QVector<quint32> hitOffsets;
+  int curCol, curItem, cur, total;
+  QString lastQuery;
+
+  BinaryObjectPtr sectionObj;
+  SectionPtr section;
+  SearchQuery::Kind searchKind;
+  RowFunc rowFunc;
+  int searchColumn, searchPerc;
+  SearchHits pendingHits;
+  SearchThread *searchThread;
+
+  LineEdit *searchEdit;
+  QLabel *searchLabel;
+};
+
+#endif // BMOD_TREE_VIEW_HELPER_H
@@ -1,14 +1,9 @@
 #ifndef BMOD_TREE_WIDGET_H
 #define BMOD_TREE_WIDGET_H
 
-#include <QMap>
-#include <QList>
 #include <QTreeWidget>
 
-#include "../CpuType.h"
-
-class QLabel;
-class LineEdit;
+#include "TreeViewHelper.h"
 
 class TreeWidget : public QTreeWidget {
   Q_OBJECT
@@ -16,45 +11,25 @@ class TreeWidget : public QTreeWidget {
 public:
   TreeWidget(QWidget *parent = nullptr);
 
-  void setCpuType(CpuType type) { cpuType = type; }
-  void setMachineCodeColumns(const QList<int> columns);
+  void setCpuType(CpuType type) { helper->setCpuType(type); }
+  void setMachineCodeColumns(const QList<int> columns) {
+    helper->setMachineCodeColumns(columns);
+  }
+
+  void setAddressColumn(int column) { helper->setAddressColumn(column); }
 
-  void setAddressColumn(int column);
+  // See TreeViewHelper::setSection().
+  void setSection(BinaryObjectPtr obj, SectionPtr sec, SearchQuery::Kind def,
+                  TreeViewHelper::RowFunc rowFunc, int column) {
+    helper->setSection(obj, sec, def, rowFunc, column);
+  }
 
 protected:
   void keyPressEvent(QKeyEvent *event);
   void resizeEvent(QResizeEvent *event);
 
-private slots:
-  void doSearch();
-  void endSearch();
-  void onSearchLostFocus();
-  void onSearchReturnPressed();
-  void nextSearchResult();
-  void prevSearchResult();
-  void onSearchEdited(const QString &text);
-  void onShowContextMenu(const QPoint &pos);
-  void disassemble();
-  void copyField();
-  void copyRow();
-  void findAddress();
-
 private:
-  void resetSearch();
-  void selectSearchResult(int col, int item);
-  void showSearchText(const QString &text);
-
-  QList<int> machineCodeColumns;
-  CpuType cpuType;
-  QTreeWidgetItem *ctxItem;
-  int ctxCol, addrColumn;
-
-  QMap<int, QList<QTreeWidgetItem*>> searchResults;
-  int curCol, curItem, cur, total;
-  QString lastQuery;
-
-  LineEdit *searchEdit;
-  QLabel *searchLabel;
+  TreeViewHelper *helper;
 };
 
 #endif // BMOD_TREE_WIDGET_H
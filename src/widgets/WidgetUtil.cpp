@@ -0,0 +1,18 @@
+#include <QWidget>
+#include <QApplication>
+#include <QDesktopWidget>
+#include <QTreeWidgetItem>
+
+#include "WidgetUtil.h"
+
+void WidgetUtil::centerWidget(QWidget *widget) {
+  widget->move(QApplication::desktop()->screen()->rect().center()
+               - widget->rect().center());
+}
+
+void WidgetUtil::setTreeItemMarked(QTreeWidgetItem *item, int column) {
+  auto font = item->font(column);
+  font.setBold(true);
+  item->setFont(column, font);
+  item->setForeground(column, Qt::red);
+}
@@ -0,0 +1,15 @@
+#ifndef BMOD_WIDGET_UTIL_H
+#define BMOD_WIDGET_UTIL_H
+
+class QWidget;
+class QTreeWidgetItem;
+
+// Helpers that need the widgets module, kept apart from Util so the
+// core can be built without it.
+class WidgetUtil {
+public:
+  static void centerWidget(QWidget *widget);
+  static void setTreeItemMarked(QTreeWidgetItem *item, int column);
+};
+
+#endif // BMOD_WIDGET_UTIL_H